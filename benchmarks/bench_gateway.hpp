@@ -0,0 +1,140 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench_loopback.hpp"
+#include "bench_router.hpp"
+#include "gateway.hpp"
+#include "reply_encoder.hpp"
+#include "stream_socket.hpp"
+
+using namespace Play;
+
+namespace GatewayBench
+{
+
+constexpr size_t WARMUP = 1000;
+constexpr size_t ROUNDS = 20000;
+// over ClientMessage::INLINE_BODY_CAPACITY, so bodies take the zero-copy
+// path through the gateway
+constexpr uint16_t BODY_SIZE = 256;
+
+// answers every request with a reply frame carrying the same body, the way
+// a service behind the gateway would
+inline void serveBackend(RouterSocket &backend,
+                         const std::atomic<bool> &running)
+{
+    RouterMessageBatch batch(64);
+    while (running.load(std::memory_order_acquire))
+    {
+        backend.recvBatch(batch,
+                          batch.capacity(),
+                          std::chrono::milliseconds(10));
+        for (RouterMessage &message : batch)
+        {
+            if (message.Header().size() != GatewayEnvelope::SIZE)
+            {
+                // the gateway socket's handshake message
+                continue;
+            }
+            GatewayEnvelope envelope =
+                GatewayEnvelope::decode(message.Header());
+            if (envelope.type != MessageType::NORMAL)
+            {
+                continue;
+            }
+
+            auto reply = RouterSocket::makeClientMessageBody(
+                static_cast<uint16_t>(message.body().size()),
+                envelope.header.service_id,
+                envelope.header.msg_id,
+                envelope.header.msg_seq,
+                0,
+                envelope.header.stage_index,
+                static_cast<const unsigned char *>(message.body().data()));
+            RouterMessage response(std::move(message.target()),
+                                   std::move(message.Header()),
+                                   std::move(*reply));
+            backend.send(response);
+        }
+    }
+}
+
+// one blocking client sends a request, waits for the reply and repeats;
+// every round trip crosses client socket -> gateway -> backend and back
+inline void run(int32_t clientPort, int32_t backendPort)
+{
+    auto context = RouterSocket::makeContext(SocketConfig(""));
+    std::string endpoint = fmt::format("tcp://127.0.0.1:{}", backendPort);
+
+    RouterSocket backend(context, "", endpoint);
+    backend.bind();
+    RouterSocket gatewaySocket(context, "", "gateway");
+    gatewaySocket.connect(endpoint);
+    RouterBench::sendFirst(gatewaySocket, endpoint);
+
+    std::atomic<bool> running{true};
+    std::thread backendThread([&]() { serveBackend(backend, running); });
+
+    auto clients = std::make_shared<StreamSocket>();
+    clients->bind(clientPort);
+
+    GatewayConfig config;
+    // makeClientFrames() sends service 1
+    config.routes = {{1, endpoint}};
+    Gateway<StreamSocket> gateway(clients, gatewaySocket, config);
+    gateway.start();
+
+    int fd = LoopbackBench::connectTo(clientPort);
+    auto request = makeClientFrames(1, BODY_SIZE);
+    std::vector<unsigned char> reply(ReplyEncoder::HEADROOM + BODY_SIZE);
+
+    std::vector<double> samples;
+    samples.reserve(ROUNDS);
+    for (size_t round = 0; round < WARMUP + ROUNDS; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        LoopbackBench::writeAll(fd, request.data(), request.size());
+        LoopbackBench::readAll(fd, reply.data(), reply.size());
+        auto end = std::chrono::steady_clock::now();
+
+        if (round >= WARMUP)
+        {
+            samples.push_back(
+                std::chrono::duration<double, std::micro>(end - start)
+                    .count());
+        }
+    }
+
+    ::close(fd);
+    gateway.stop();
+    clients->close();
+    running.store(false, std::memory_order_release);
+    backendThread.join();
+
+    std::sort(samples.begin(), samples.end());
+    fmt::print("{:<48} p50 {:>8.1f} us  p99 {:>8.1f} us\n",
+               fmt::format("gateway round trip {}B bodies", BODY_SIZE),
+               samples[samples.size() / 2],
+               samples[samples.size() * 99 / 100]);
+}
+
+} // namespace GatewayBench
+
+inline void benchGatewayLatency()
+{
+    GatewayBench::run(47301, 47302);
+}
+
+#endif
@@ -0,0 +1,188 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_stream_parser.hpp"
+#include "bench_util.hpp"
+#include "reply_encoder.hpp"
+#include "stream_socket.hpp"
+
+#if defined(PLAYSOCKET_IO_URING)
+#include "uring_stream_socket.hpp"
+#endif
+
+using namespace Play;
+
+namespace LoopbackBench
+{
+
+constexpr size_t CLIENTS = 4;
+constexpr size_t ROUNDS = 2000;
+// frames each client keeps in flight before it reads the echoes
+constexpr size_t WINDOW = 16;
+constexpr uint16_t BODY_SIZE = 64;
+
+inline int connectTo(int32_t port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // the server may still be starting up
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (::connect(fd,
+                      reinterpret_cast<sockaddr *>(&address),
+                      sizeof(address)) == 0)
+        {
+            int enable = 1;
+            ::setsockopt(fd,
+                         IPPROTO_TCP,
+                         TCP_NODELAY,
+                         &enable,
+                         sizeof(enable));
+            return fd;
+        }
+        ::close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    throw std::runtime_error("loopback connect failed");
+}
+
+inline void writeAll(int fd, const unsigned char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written <= 0)
+        {
+            throw std::runtime_error("loopback send failed");
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+inline void readAll(int fd, unsigned char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t read = ::recv(fd, data, size, 0);
+        if (read <= 0)
+        {
+            throw std::runtime_error("loopback recv failed");
+        }
+        data += read;
+        size -= static_cast<size_t>(read);
+    }
+}
+
+// echoes every frame back to its session as a reply frame, the reply
+// header followed by the body, until `running` clears
+template <typename Socket>
+void serve(Socket &socket, const std::atomic<bool> &running)
+{
+    while (running.load(std::memory_order_acquire))
+    {
+        auto message = socket.recvWait(std::chrono::milliseconds(10));
+        if (message == nullptr || message->type() != MessageType::NORMAL)
+        {
+            continue;
+        }
+        ReplyHeader header;
+        static_cast<Header &>(header) = message->header();
+        auto reply = std::make_unique<zmq::message_t>(
+            ReplyEncoder::encode(header, message->bodyView()));
+        socket.send(ClientMessage(message->sid(),
+                                  message->header(),
+                                  std::move(reply)));
+    }
+}
+
+// CLIENTS blocking clients each send WINDOW frames, read the echoes and
+// repeat; one operation is one echoed frame
+template <typename Socket>
+void run(const std::string &name, int32_t port)
+{
+    auto socket = std::make_shared<Socket>();
+    socket->bind(port);
+
+    std::atomic<bool> running{true};
+    std::thread server([&]() { serve(*socket, running); });
+
+    std::vector<int> clients;
+    for (size_t i = 0; i < CLIENTS; i++)
+    {
+        clients.push_back(connectTo(port));
+    }
+
+    auto frames = makeClientFrames(WINDOW, BODY_SIZE);
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int fd : clients)
+    {
+        threads.emplace_back([&frames, fd]() {
+            std::vector<unsigned char> echoes(
+                WINDOW * (ReplyHeaderCodec::SIZE + BODY_SIZE));
+            for (size_t round = 0; round < ROUNDS; round++)
+            {
+                writeAll(fd, frames.data(), frames.size());
+                readAll(fd, echoes.data(), echoes.size());
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    for (int fd : clients)
+    {
+        ::close(fd);
+    }
+    running.store(false, std::memory_order_release);
+    server.join();
+    socket->close();
+
+    size_t operations = CLIENTS * ROUNDS * WINDOW;
+    Bench::report(name,
+                  Bench::Result{std::chrono::duration<double>(end - start)
+                                    .count(),
+                                operations,
+                                operations * BODY_SIZE});
+}
+
+} // namespace LoopbackBench
+
+inline void benchLoopbackAsio()
+{
+    LoopbackBench::run<StreamSocket>("echo asio 4 clients x 16 in flight",
+                                     47101);
+}
+
+#if defined(PLAYSOCKET_IO_URING)
+inline void benchLoopbackUring()
+{
+    LoopbackBench::run<UringStreamSocket>(
+        "echo io_uring 4 clients x 16 in flight",
+        47102);
+}
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include "bench_util.hpp"
+#include "ring_buffer.hpp"
+
+using namespace Play;
+
+inline void benchRingBuffer()
+{
+    const size_t chunkSizes[] = {64, 1024, 64 * 1024};
+    const size_t totalBytes = 64 * 1024 * 1024;
+
+    for (size_t chunkSize : chunkSizes)
+    {
+        std::vector<unsigned char> input(chunkSize, 0x5A);
+        std::vector<unsigned char> output(chunkSize);
+        size_t operations = totalBytes / chunkSize;
+
+        // the per-byte path the ring used before the bulk engine
+        RingBuffer perByte(1024 * 8, 1024 * 64 * 8);
+        auto result = Bench::measure(operations, chunkSize, [&]() {
+            for (unsigned char b : input)
+            {
+                perByte.push(b);
+            }
+            for (size_t i = 0; i < chunkSize; i++)
+            {
+                output[i] = perByte.pop();
+            }
+            Bench::doNotOptimize(output.data());
+        });
+        Bench::report(
+            fmt::format("RingBuffer per-byte write/read {}B", chunkSize),
+            result);
+
+        RingBuffer bulk(1024 * 8, 1024 * 64 * 8);
+        result = Bench::measure(operations, chunkSize, [&]() {
+            bulk.write(input.data(), 0, chunkSize);
+            bulk.read(output.data(), 0, chunkSize);
+            Bench::doNotOptimize(output.data());
+        });
+        Bench::report(fmt::format("RingBuffer bulk write/read {}B", chunkSize),
+                      result);
+    }
+}
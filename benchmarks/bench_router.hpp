@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "bench_util.hpp"
+#include "router_socket.hpp"
+
+using namespace Play;
+
+namespace RouterBench
+{
+
+constexpr size_t CLIENTS = 4;
+constexpr size_t MESSAGES_PER_CLIENT = 50000;
+constexpr size_t BODY_SIZE = 256;
+
+// sends until the handshake is done; router_mandatory rejects messages to
+// a peer that is not connected yet
+inline void sendFirst(RouterSocket &socket, const std::string &target)
+{
+    while (true)
+    {
+        RouterMessage message(target, "h", zmq::message_t(BODY_SIZE));
+        try
+        {
+            if (socket.send(message))
+            {
+                return;
+            }
+        }
+        catch (zmq::error_t &)
+        {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// CLIENTS router sockets stream to one server over TCP loopback, all on
+// one context with `ioThreads` I/O threads
+inline void run(int ioThreads, int32_t port)
+{
+    SocketConfig config(fmt::format("--io_threads={}", ioThreads));
+    auto context = RouterSocket::makeContext(config);
+
+    std::string endpoint = fmt::format("tcp://127.0.0.1:{}", port);
+    RouterSocket server(context, "", endpoint);
+    server.bind();
+
+    std::vector<std::unique_ptr<RouterSocket>> clients;
+    for (size_t i = 0; i < CLIENTS; i++)
+    {
+        clients.push_back(std::make_unique<RouterSocket>(
+            context,
+            "",
+            fmt::format("bench-client-{}", i)));
+        clients.back()->connect(endpoint);
+    }
+
+    size_t total = CLIENTS * MESSAGES_PER_CLIENT;
+    size_t received = 0;
+    RouterMessageBatch batch(256);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (auto &client : clients)
+    {
+        threads.emplace_back([&client, &endpoint]() {
+            sendFirst(*client, endpoint);
+            for (size_t i = 1; i < MESSAGES_PER_CLIENT; i++)
+            {
+                RouterMessage message(endpoint,
+                                      "h",
+                                      zmq::message_t(BODY_SIZE));
+                client->send(message);
+            }
+        });
+    }
+
+    while (received < total)
+    {
+        received += server.recvBatch(batch,
+                                     batch.capacity(),
+                                     std::chrono::milliseconds(100));
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    Bench::report(fmt::format("router {} clients, {} io threads",
+                              CLIENTS,
+                              ioThreads),
+                  Bench::Result{std::chrono::duration<double>(end - start)
+                                    .count(),
+                                total,
+                                total * BODY_SIZE});
+}
+
+} // namespace RouterBench
+
+inline void benchRouterIoThreads()
+{
+    int32_t port = 47201;
+    for (int ioThreads : {1, 2, 4})
+    {
+        RouterBench::run(ioThreads, port++);
+    }
+}
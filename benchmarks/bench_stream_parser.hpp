@@ -0,0 +1,146 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include "bench_util.hpp"
+#include "header_codec.hpp"
+#include "mirrored_ring_buffer.hpp"
+#include "ring_buffer.hpp"
+#include "stream_parser.hpp"
+
+using namespace Play;
+
+// client-to-server frames: the reply layout minus the error code
+inline std::vector<unsigned char> makeClientFrames(size_t frameCount,
+                                                   uint16_t bodySize)
+{
+    std::vector<unsigned char> frames;
+
+    for (size_t i = 0; i < frameCount; i++)
+    {
+        Header header(1,
+                      static_cast<int32_t>(i),
+                      static_cast<int16_t>(i),
+                      0);
+
+        size_t offset = frames.size();
+        frames.resize(offset + HEADER_SIZE + bodySize, 0x5A);
+        ClientHeaderCodec::encode(frames.data() + offset, bodySize, header);
+    }
+    return frames;
+}
+
+template <typename Buffer>
+void benchParseLoop(const std::string &name,
+                    const std::vector<unsigned char> &chunk,
+                    size_t framesPerChunk)
+{
+    BasicStreamParser<Buffer> parser(1);
+    size_t operations = 20000;
+
+    auto result = Bench::measure(operations, chunk.size(), [&]() {
+        parser.write(chunk.data(), 0, chunk.size());
+        auto messages = parser.parse();
+        if (messages.size() != framesPerChunk)
+        {
+            throw std::runtime_error("unexpected frame count");
+        }
+        Bench::doNotOptimize(&messages);
+    });
+    Bench::report(name, result);
+}
+
+// the session path: frames decoded straight from the received chunk
+inline void benchDirectParse(const std::string &name,
+                             const std::vector<unsigned char> &chunk,
+                             size_t framesPerChunk)
+{
+    StreamParser parser(1);
+    size_t operations = 20000;
+
+    auto result = Bench::measure(operations, chunk.size(), [&]() {
+        auto messages = parser.parse(chunk.data(), 0, chunk.size());
+        if (messages.size() != framesPerChunk)
+        {
+            throw std::runtime_error("unexpected frame count");
+        }
+        Bench::doNotOptimize(&messages);
+    });
+    Bench::report(name, result);
+}
+
+inline void benchStreamParser()
+{
+    const uint16_t bodySizes[] = {16, 64, 512};
+    const size_t framesPerChunk = 32;
+
+    for (uint16_t bodySize : bodySizes)
+    {
+        auto chunk = makeClientFrames(framesPerChunk, bodySize);
+
+        benchParseLoop<RingBuffer>(
+            fmt::format("parse modulo ring {}B bodies", bodySize),
+            chunk,
+            framesPerChunk);
+        benchParseLoop<PowerOfTwoRingBuffer>(
+            fmt::format("parse power-of-two ring {}B bodies", bodySize),
+            chunk,
+            framesPerChunk);
+        benchParseLoop<MirroredRingBuffer>(
+            fmt::format("parse mirrored ring {}B bodies", bodySize),
+            chunk,
+            framesPerChunk);
+        benchDirectParse(
+            fmt::format("parse direct from chunk {}B bodies", bodySize),
+            chunk,
+            framesPerChunk);
+    }
+}
+
+// frames/s for each way of taking messages out of the parser
+inline void benchParserSink()
+{
+    const uint16_t bodySize = 32;
+    const size_t framesPerChunk = 32;
+    const size_t operations = 20000;
+    auto chunk = makeClientFrames(framesPerChunk, bodySize);
+
+    auto reportFrames = [&](const std::string &name, Bench::Result result) {
+        result.operations *= framesPerChunk;
+        Bench::report(name, result);
+    };
+
+    {
+        StreamParser parser(1);
+        reportFrames("frames into std::list",
+                     Bench::measure(operations, chunk.size(), [&]() {
+                         auto messages =
+                             parser.parse(chunk.data(), 0, chunk.size());
+                         Bench::doNotOptimize(&messages);
+                     }));
+    }
+    {
+        StreamParser parser(1);
+        std::vector<std::unique_ptr<ClientMessage>> messages;
+        messages.reserve(framesPerChunk);
+        reportFrames("frames into reused std::vector",
+                     Bench::measure(operations, chunk.size(), [&]() {
+                         messages.clear();
+                         parser.parse(chunk.data(), 0, chunk.size(), messages);
+                         Bench::doNotOptimize(messages.data());
+                     }));
+    }
+    {
+        StreamParser parser(1);
+        reportFrames(
+            "frames into callback sink",
+            Bench::measure(operations, chunk.size(), [&]() {
+                parser.parse(chunk.data(),
+                             0,
+                             chunk.size(),
+                             [](std::unique_ptr<ClientMessage> message) {
+                                 Bench::doNotOptimize(message.get());
+                             });
+            }));
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace Bench
+{
+
+struct Result
+{
+    double seconds = 0;
+    size_t operations = 0;
+    size_t bytes = 0;
+};
+
+inline const void *volatile sink = nullptr;
+
+// keeps the optimizer from discarding benchmarked work without inline asm,
+// which MSVC does not support on x64.
+inline void doNotOptimize(const void *value)
+{
+    sink = value;
+}
+
+template <typename Fn>
+Result measure(size_t operations, size_t bytesPerOperation, Fn &&fn)
+{
+    // warm up caches and let the buffers reach their steady-state capacity
+    for (size_t i = 0; i < operations / 10 + 1; i++)
+    {
+        fn();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < operations; i++)
+    {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return Result{std::chrono::duration<double>(end - start).count(),
+                  operations,
+                  operations * bytesPerOperation};
+}
+
+inline void report(const std::string &name, const Result &result)
+{
+    double opsPerSec = result.operations / result.seconds;
+    double mbPerSec = result.bytes / result.seconds / (1024.0 * 1024.0);
+
+    fmt::print("{:<48} {:>14.0f} ops/s {:>12.1f} MB/s\n",
+               name,
+               opsPerSec,
+               mbPerSec);
+}
+
+} // namespace Bench
@@ -0,0 +1,59 @@
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "bench_gateway.hpp"
+#include "bench_loopback.hpp"
+#include "bench_ring_buffer.hpp"
+#include "bench_router.hpp"
+#include "bench_stream_parser.hpp"
+
+int main(int argc, char **argv)
+{
+    const std::vector<std::pair<std::string, std::function<void()>>>
+        benchmarks = {
+            {"ring_buffer", benchRingBuffer},
+            {"stream_parser", benchStreamParser},
+            {"parser_sink", benchParserSink},
+            {"router_io_threads", benchRouterIoThreads},
+#if defined(__linux__)
+            {"loopback_asio", benchLoopbackAsio},
+            {"gateway_latency", benchGatewayLatency},
+#endif
+#if defined(PLAYSOCKET_IO_URING)
+            {"loopback_uring", benchLoopbackUring},
+#endif
+        };
+
+    cxxopts::Options options("playsocket_benchmarks",
+                             "PlaySocket micro benchmarks");
+    options.add_options()("h,help", "Print usage")(
+        "f,filter",
+        "Run only benchmarks whose name contains this string",
+        cxxopts::value<std::string>()->default_value(""));
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help"))
+    {
+        std::cout << options.help() << '\n';
+        return 0;
+    }
+
+    const auto filter = result["filter"].as<std::string>();
+
+    for (const auto &[name, run] : benchmarks)
+    {
+        if (name.find(filter) != std::string::npos)
+        {
+            std::cout << "[" << name << "]" << '\n';
+            run();
+        }
+    }
+
+    return 0;
+}
@@ -1,11 +1,82 @@
 #pragma once
 
 #include <bit>
+#include <concepts>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 class BitConverter
 {
 public:
+    // std::byteswap is C++23; the builtins compile to a single bswap/rev
+    template <std::integral T>
+    static constexpr T byteswap(T value)
+    {
+#if defined(__cpp_lib_byteswap)
+        return std::byteswap(value);
+#else
+        if constexpr (sizeof(T) == 1)
+        {
+            return value;
+        }
+#if defined(__GNUC__) || defined(__clang__)
+        else if constexpr (sizeof(T) == 2)
+        {
+            return static_cast<T>(
+                __builtin_bswap16(static_cast<uint16_t>(value)));
+        }
+        else if constexpr (sizeof(T) == 4)
+        {
+            return static_cast<T>(
+                __builtin_bswap32(static_cast<uint32_t>(value)));
+        }
+        else
+        {
+            return static_cast<T>(
+                __builtin_bswap64(static_cast<uint64_t>(value)));
+        }
+#else
+        else
+        {
+            using Unsigned = std::make_unsigned_t<T>;
+            auto bits = static_cast<Unsigned>(value);
+            Unsigned swapped = 0;
+            for (size_t i = 0; i < sizeof(T); i++)
+            {
+                swapped = static_cast<Unsigned>((swapped << 8) | (bits & 0xFF));
+                bits = static_cast<Unsigned>(bits >> 8);
+            }
+            return static_cast<T>(swapped);
+        }
+#endif
+#endif
+    }
+
+    // reads a big-endian value from a possibly unaligned address
+    template <std::integral T>
+    static T loadNetwork(const unsigned char *source)
+    {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            value = byteswap(value);
+        }
+        return value;
+    }
+
+    // writes `value` big-endian to a possibly unaligned address
+    template <std::integral T>
+    static void storeNetwork(unsigned char *destination, T value)
+    {
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            value = byteswap(value);
+        }
+        std::memcpy(destination, &value, sizeof(T));
+    }
+
     static uint16_t toNetwork(uint16_t value)
     {
         if constexpr (std::endian::native == std::endian::big)
@@ -0,0 +1,490 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Play
+{
+
+// Size-class pool for ring buffer storage. Power-of-two sizes from 8KB to
+// 512KB are carved out of 2MB slabs; freed blocks go to a per-thread cache
+// first and spill over to a shared depot, so sessions connecting and
+// resizing on the I/O threads reuse memory without touching the allocator.
+// Any other size is a plain heap allocation.
+//
+// A depot keeps up to its limit of free bytes resident. Blocks above it are
+// released to the system with madvise(MADV_DONTNEED) and stay in the depot,
+// to be faulted back in as zeroed pages when they are handed out again.
+class BufferPool
+{
+public:
+    static constexpr size_t MIN_BLOCK_SIZE = 1024 * 8;
+    static constexpr size_t MAX_BLOCK_SIZE = 1024 * 512;
+    static constexpr size_t SLAB_SIZE = 1024 * 1024 * 2;
+    static constexpr size_t CLASS_COUNT = std::countr_zero(MAX_BLOCK_SIZE) -
+                                          std::countr_zero(MIN_BLOCK_SIZE) + 1;
+    // bytes of each size class a single thread keeps for itself
+    static constexpr size_t THREAD_CACHE_BYTES = 1024 * 256;
+    // free bytes of each size class a depot keeps resident by default
+    static constexpr size_t DEPOT_LIMIT_BYTES = SLAB_SIZE * 4;
+
+    struct Stats
+    {
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t threadCacheHits = 0;
+        uint64_t depotHits = 0;
+        // calls into the system allocator: slabs plus unpooled sizes
+        uint64_t slabAllocations = 0;
+        uint64_t unpooledAllocations = 0;
+        // bytes of all slabs carved so far
+        uint64_t pooledBytes = 0;
+        // free bytes in the depots that are still resident, and those
+        // released to the system; blocks in thread caches are in neither
+        uint64_t freeBytes = 0;
+        uint64_t releasedBytes = 0;
+    };
+
+    static BufferPool &instance()
+    {
+        // intentionally leaked so thread caches can flush into it at exit
+        static BufferPool *pool = new BufferPool();
+        return *pool;
+    }
+
+    static bool isPooledSize(size_t size)
+    {
+        return size >= MIN_BLOCK_SIZE && size <= MAX_BLOCK_SIZE &&
+               std::has_single_bit(size);
+    }
+
+    // back new slabs with transparent hugepages where the platform has them
+    void setHugePages(bool enable)
+    {
+        _hugePages.store(enable, std::memory_order_relaxed);
+    }
+
+    // free bytes each depot keeps resident before releasing the rest
+    void setDepotLimit(size_t bytes)
+    {
+        _depotLimit.store(bytes, std::memory_order_relaxed);
+    }
+
+    size_t depotLimit() const
+    {
+        return _depotLimit.load(std::memory_order_relaxed);
+    }
+
+    unsigned char *allocate(size_t size)
+    {
+        _allocations.fetch_add(1, std::memory_order_relaxed);
+
+        if (!isPooledSize(size))
+        {
+            _unpooledAllocations.fetch_add(1, std::memory_order_relaxed);
+            return new unsigned char[size];
+        }
+
+        size_t index = classIndex(size);
+        ThreadCache *cache = threadCache();
+        if (cache == nullptr)
+        {
+            return allocateUncached(index);
+        }
+
+        auto &cached = cache->blocks[index];
+        if (cached.empty())
+        {
+            refill(index, cached);
+        }
+        else
+        {
+            _threadCacheHits.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        unsigned char *block = cached.back();
+        cached.pop_back();
+        return block;
+    }
+
+    void deallocate(unsigned char *block, size_t size)
+    {
+        if (block == nullptr)
+        {
+            return;
+        }
+        _deallocations.fetch_add(1, std::memory_order_relaxed);
+
+        if (!isPooledSize(size))
+        {
+            delete[] block;
+            return;
+        }
+
+        size_t index = classIndex(size);
+        ThreadCache *cache = threadCache();
+        if (cache == nullptr)
+        {
+            std::vector<unsigned char *> single{block};
+            spill(index, single, 1);
+            return;
+        }
+
+        auto &cached = cache->blocks[index];
+        if (cached.size() == cacheLimit(index))
+        {
+            spill(index, cached, cached.size() / 2);
+        }
+        cached.push_back(block);
+    }
+
+    Stats stats() const
+    {
+        Stats stats;
+        stats.allocations = _allocations.load(std::memory_order_relaxed);
+        stats.deallocations = _deallocations.load(std::memory_order_relaxed);
+        stats.threadCacheHits =
+            _threadCacheHits.load(std::memory_order_relaxed);
+        stats.depotHits = _depotHits.load(std::memory_order_relaxed);
+        stats.slabAllocations =
+            _slabAllocations.load(std::memory_order_relaxed);
+        stats.unpooledAllocations =
+            _unpooledAllocations.load(std::memory_order_relaxed);
+        stats.pooledBytes = stats.slabAllocations * SLAB_SIZE;
+        for (size_t i = 0; i < CLASS_COUNT; i++)
+        {
+            auto &depot = _depots[i];
+            std::lock_guard<std::mutex> lock(depot.lock);
+            stats.freeBytes += depot.blocks.size() * classSize(i);
+            stats.releasedBytes += depot.released.size() * classSize(i);
+        }
+        return stats;
+    }
+
+private:
+    struct Depot
+    {
+        std::mutex lock;
+        // resident free blocks
+        std::vector<unsigned char *> blocks;
+        // free blocks whose pages were given back to the system
+        std::vector<unsigned char *> released;
+    };
+
+    struct ThreadCache
+    {
+        std::array<std::vector<unsigned char *>, CLASS_COUNT> blocks;
+
+        ThreadCache()
+        {
+            for (size_t i = 0; i < CLASS_COUNT; i++)
+            {
+                blocks[i].reserve(cacheLimit(i));
+            }
+        }
+
+        ~ThreadCache()
+        {
+            for (size_t i = 0; i < CLASS_COUNT; i++)
+            {
+                BufferPool::instance().spill(i, blocks[i], blocks[i].size());
+            }
+            cacheDestroyed() = true;
+        }
+    };
+
+    mutable std::array<Depot, CLASS_COUNT> _depots;
+    std::atomic<bool> _hugePages{false};
+    std::atomic<size_t> _depotLimit{DEPOT_LIMIT_BYTES};
+    std::atomic<uint64_t> _allocations{0};
+    std::atomic<uint64_t> _deallocations{0};
+    std::atomic<uint64_t> _threadCacheHits{0};
+    std::atomic<uint64_t> _depotHits{0};
+    std::atomic<uint64_t> _slabAllocations{0};
+    std::atomic<uint64_t> _unpooledAllocations{0};
+
+    BufferPool() = default;
+
+    // trivially destructible, so it can still be read while the thread's
+    // other thread_locals, or on the main thread static objects, are
+    // being destroyed
+    static bool &cacheDestroyed()
+    {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    // nullptr once the thread's cache is gone; blocks released from later
+    // destructors then go through the depots
+    static ThreadCache *threadCache()
+    {
+        if (cacheDestroyed())
+        {
+            return nullptr;
+        }
+        thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    static size_t classIndex(size_t size)
+    {
+        return static_cast<size_t>(std::countr_zero(size) -
+                                   std::countr_zero(MIN_BLOCK_SIZE));
+    }
+
+    static size_t classSize(size_t index)
+    {
+        return MIN_BLOCK_SIZE << index;
+    }
+
+    static size_t cacheLimit(size_t index)
+    {
+        return std::max<size_t>(THREAD_CACHE_BYTES / classSize(index), 2);
+    }
+
+    // moves the last `count` blocks of `from` to the end of `to`
+    static void moveBlocks(std::vector<unsigned char *> &from,
+                           std::vector<unsigned char *> &to,
+                           size_t count)
+    {
+        auto first = from.end() - static_cast<std::ptrdiff_t>(count);
+        to.insert(to.end(), first, from.end());
+        from.erase(first, from.end());
+    }
+
+    // moves half a cache worth of blocks from the depot, resident ones
+    // first, carving a new slab when the depot runs dry
+    void refill(size_t index, std::vector<unsigned char *> &cached)
+    {
+        size_t wanted = cacheLimit(index) / 2;
+        auto &depot = _depots[index];
+        {
+            std::lock_guard<std::mutex> lock(depot.lock);
+            auto &source =
+                depot.blocks.empty() ? depot.released : depot.blocks;
+            if (!source.empty())
+            {
+                moveBlocks(source,
+                           cached,
+                           std::min(wanted, source.size()));
+                _depotHits.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        size_t blockSize = classSize(index);
+        unsigned char *slab = allocateSlab();
+        size_t blockCount = SLAB_SIZE / blockSize;
+        size_t keep = std::min(wanted, blockCount);
+
+        for (size_t i = 0; i < keep; i++)
+        {
+            cached.push_back(slab + i * blockSize);
+        }
+
+        std::vector<unsigned char *> rest;
+        rest.reserve(blockCount - keep);
+        for (size_t i = keep; i < blockCount; i++)
+        {
+            rest.push_back(slab + i * blockSize);
+        }
+        spill(index, rest, rest.size());
+    }
+
+    unsigned char *allocateUncached(size_t index)
+    {
+        std::vector<unsigned char *> blocks;
+        refill(index, blocks);
+        unsigned char *block = blocks.back();
+        blocks.pop_back();
+        spill(index, blocks, blocks.size());
+        return block;
+    }
+
+    void spill(size_t index, std::vector<unsigned char *> &cached, size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        auto &depot = _depots[index];
+        std::vector<unsigned char *> excess;
+        {
+            std::lock_guard<std::mutex> lock(depot.lock);
+            moveBlocks(cached, depot.blocks, count);
+
+            size_t limit = _depotLimit.load(std::memory_order_relaxed) /
+                           classSize(index);
+            if (depot.blocks.size() > limit)
+            {
+                moveBlocks(depot.blocks, excess, depot.blocks.size() - limit);
+            }
+        }
+        if (!excess.empty())
+        {
+            release(index, excess);
+        }
+    }
+
+    // gives the pages of free blocks back to the system, outside the depot
+    // lock, and files the blocks as released
+    void release(size_t index, std::vector<unsigned char *> &blocks)
+    {
+#if defined(__linux__)
+        for (unsigned char *block : blocks)
+        {
+            madvise(block, classSize(index), MADV_DONTNEED);
+        }
+        auto &depot = _depots[index];
+        std::lock_guard<std::mutex> lock(depot.lock);
+        moveBlocks(blocks, depot.released, blocks.size());
+#else
+        // heap slabs cannot give pages back, keep the blocks resident
+        auto &depot = _depots[index];
+        std::lock_guard<std::mutex> lock(depot.lock);
+        moveBlocks(blocks, depot.blocks, blocks.size());
+#endif
+    }
+
+    unsigned char *allocateSlab()
+    {
+        _slabAllocations.fetch_add(1, std::memory_order_relaxed);
+
+#if defined(__linux__)
+        // over-map by one slab so the slab can be aligned to the hugepage
+        // size, then hand the unaligned head and tail back
+        size_t mappedSize = SLAB_SIZE * 2;
+        void *mapped = mmap(nullptr,
+                            mappedSize,
+                            PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS,
+                            -1,
+                            0);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+        auto address = reinterpret_cast<uintptr_t>(mapped);
+        uintptr_t aligned = (address + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1);
+        size_t head = aligned - address;
+        size_t tail = mappedSize - head - SLAB_SIZE;
+        if (head > 0)
+        {
+            munmap(mapped, head);
+        }
+        if (tail > 0)
+        {
+            munmap(reinterpret_cast<void *>(aligned + SLAB_SIZE), tail);
+        }
+
+        auto *slab = reinterpret_cast<unsigned char *>(aligned);
+        if (_hugePages.load(std::memory_order_relaxed))
+        {
+            madvise(slab, SLAB_SIZE, MADV_HUGEPAGE);
+        }
+        return slab;
+#else
+        return static_cast<unsigned char *>(
+            ::operator new(SLAB_SIZE, std::align_val_t(MIN_BLOCK_SIZE)));
+#endif
+    }
+};
+
+// Owning storage block drawn from the BufferPool.
+class PooledStorage
+{
+public:
+    PooledStorage() = default;
+
+    explicit PooledStorage(size_t size)
+        : _data(size > 0 ? BufferPool::instance().allocate(size) : nullptr),
+          _size(size)
+    {
+    }
+
+    PooledStorage(const PooledStorage &other) : PooledStorage(other._size)
+    {
+        if (_size > 0)
+        {
+            std::memcpy(_data, other._data, _size);
+        }
+    }
+
+    PooledStorage &operator=(const PooledStorage &other)
+    {
+        if (this != &other)
+        {
+            PooledStorage copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    PooledStorage(PooledStorage &&other) noexcept
+        : _data(std::exchange(other._data, nullptr)),
+          _size(std::exchange(other._size, 0))
+    {
+    }
+
+    PooledStorage &operator=(PooledStorage &&other) noexcept
+    {
+        if (this != &other)
+        {
+            BufferPool::instance().deallocate(_data, _size);
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+
+    ~PooledStorage()
+    {
+        BufferPool::instance().deallocate(_data, _size);
+    }
+
+    unsigned char *data()
+    {
+        return _data;
+    }
+
+    const unsigned char *data() const
+    {
+        return _data;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    unsigned char &operator[](size_t index)
+    {
+        return _data[index];
+    }
+
+    const unsigned char &operator[](size_t index) const
+    {
+        return _data[index];
+    }
+
+private:
+    unsigned char *_data = nullptr;
+    size_t _size = 0;
+};
+
+} // namespace Play
@@ -1,8 +1,22 @@
 #include "client_message.hpp"
 
+#include <cstring>
+
+#include "object_pool.hpp"
+
 namespace Play
 {
 
+using ClientMessagePool =
+    ObjectPool<sizeof(ClientMessage), alignof(ClientMessage)>;
+
+static ClientMessagePool &messagePool()
+{
+    // intentionally leaked so messages can still be freed during shutdown
+    static ClientMessagePool *pool = new ClientMessagePool();
+    return *pool;
+}
+
 ClientMessage::ClientMessage(int64_t sid, const MessageType &type)
     : _sid(sid), _type(type), _header(Play::Header(0, 0, 0, 0)), _body(nullptr)
 {
@@ -13,12 +27,51 @@ ClientMessage::ClientMessage(int64_t sid,
     : _sid(sid), _header(header), _body(std::move(body))
 {
 }
+ClientMessage::ClientMessage(int64_t sid,
+                             const Play::Header &header,
+                             const unsigned char *body,
+                             size_t size)
+    : _sid(sid), _header(header)
+{
+    if (size <= INLINE_BODY_CAPACITY)
+    {
+        _inline = true;
+        _inlineSize = static_cast<uint16_t>(size);
+        if (size > 0)
+        {
+            std::memcpy(_inlineBody.data(), body, size);
+        }
+    }
+    else
+    {
+        _body = std::make_unique<zmq::message_t>(body, size);
+    }
+}
 // ClientMessage::ClientMessage(ClientMessage &&other) noexcept
 //     : _sid(std::move(other._sid)), _header(std::move(other._header)),
 //       _body(std::move(other._body)), _type(std::move(other._type))
 // {
 // }
 
+void *ClientMessage::operator new(size_t size)
+{
+    // a derived class does not fit the pool's slots
+    if (size != sizeof(ClientMessage))
+    {
+        return ::operator new(size);
+    }
+    return messagePool().allocate();
+}
+void ClientMessage::operator delete(void *pointer, size_t size)
+{
+    if (size != sizeof(ClientMessage))
+    {
+        ::operator delete(pointer);
+        return;
+    }
+    messagePool().deallocate(pointer);
+}
+
 const int64_t ClientMessage::sid() const
 {
     return _sid;
@@ -29,8 +82,31 @@ const Header &ClientMessage::header() const
 };
 std::unique_ptr<zmq::message_t> ClientMessage::body()
 {
+    if (_inline)
+    {
+        _inline = false;
+        return std::make_unique<zmq::message_t>(_inlineBody.data(),
+                                                _inlineSize);
+    }
     return std::move(_body);
 };
+std::span<const unsigned char> ClientMessage::bodyView() const
+{
+    if (_inline)
+    {
+        return {_inlineBody.data(), _inlineSize};
+    }
+    if (_body != nullptr)
+    {
+        return {static_cast<const unsigned char *>(_body->data()),
+                _body->size()};
+    }
+    return {};
+}
+bool ClientMessage::hasInlineBody() const
+{
+    return _inline;
+}
 const MessageType &ClientMessage::type() const
 {
     return _type;
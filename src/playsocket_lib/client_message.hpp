@@ -1,5 +1,9 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <zmq.hpp>
 
 namespace Play
@@ -7,16 +11,17 @@ namespace Play
 
 struct Header
 {
+    Header() = default;
     Header(int16_t service_id,
            int32_t msg_id,
            int16_t msg_seq,
            int8_t stage_index)
         : service_id(service_id), msg_id(msg_id), msg_seq(msg_seq),
           stage_index(stage_index){};
-    int16_t service_id;
-    int32_t msg_id;
-    int16_t msg_seq;
-    int8_t stage_index;
+    int16_t service_id = 0;
+    int32_t msg_id = 0;
+    int16_t msg_seq = 0;
+    int8_t stage_index = 0;
 };
 
 enum MessageType
@@ -26,24 +31,46 @@ enum MessageType
     NORMAL = 3
 };
 
+// Messages come from a process-wide lock-free pool. Bodies of up to
+// INLINE_BODY_CAPACITY bytes are stored inside the message; larger bodies
+// stay in a zmq::message_t so they can be handed on without a copy.
 class ClientMessage
 {
+public:
+    static constexpr size_t INLINE_BODY_CAPACITY = 64;
+
 private:
     int64_t _sid;
     Header _header;
     std::unique_ptr<zmq::message_t> _body;
     MessageType _type = MessageType::NORMAL;
+    bool _inline = false;
+    uint16_t _inlineSize = 0;
+    std::array<unsigned char, INLINE_BODY_CAPACITY> _inlineBody;
 
 public:
     explicit ClientMessage(int64_t _sid, const MessageType &type);
     explicit ClientMessage(int64_t _sid,
                            const Header &header,
                            std::unique_ptr<zmq::message_t> body);
+    // copies the body, inline when it fits
+    explicit ClientMessage(int64_t _sid,
+                           const Header &header,
+                           const unsigned char *body,
+                           size_t size);
     // explicit ClientMessage(ClientMessage &&other) noexcept;
 
+    static void *operator new(size_t size);
+    static void operator delete(void *pointer, size_t size);
+
     const int64_t sid() const;
     const Header &header() const;
+    // takes the body out of the message; an inline body is copied into a
+    // new zmq::message_t
     std::unique_ptr<zmq::message_t> body();
+    // the body bytes without taking them out of the message
+    std::span<const unsigned char> bodyView() const;
+    bool hasInlineBody() const;
     const MessageType &type() const;
 };
 
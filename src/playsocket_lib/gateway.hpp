@@ -0,0 +1,352 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <zmq.hpp>
+
+#include "bit_converter.hpp"
+#include "client_message.hpp"
+#include "header_codec.hpp"
+#include "logger_interface.hpp"
+#include "outbound_queue.hpp"
+#include "router_message.hpp"
+#include "router_socket.hpp"
+
+namespace Play
+{
+
+// The header frame of every message between the gateway and a backend:
+// which session it belongs to, what kind of message it is and the client
+// frame header. Big-endian, like the client frames:
+// sid(8) type(1) service_id(2) msg_id(4) msg_seq(2) error_code(2)
+// stage_index(1). At 20 bytes it stays inside a zmq::message_t.
+struct GatewayEnvelope
+{
+    static constexpr size_t SIZE = 20;
+
+    int64_t sid = 0;
+    MessageType type = MessageType::NORMAL;
+    ReplyHeader header{};
+
+    zmq::message_t encode() const
+    {
+        zmq::message_t frame(SIZE);
+        auto *bytes = static_cast<unsigned char *>(frame.data());
+        BitConverter::storeNetwork<int64_t>(bytes, sid);
+        bytes[8] = static_cast<unsigned char>(type);
+        BitConverter::storeNetwork<int16_t>(bytes + 9, header.service_id);
+        BitConverter::storeNetwork<int32_t>(bytes + 11, header.msg_id);
+        BitConverter::storeNetwork<int16_t>(bytes + 15, header.msg_seq);
+        BitConverter::storeNetwork<int16_t>(bytes + 17, header.error_code);
+        BitConverter::storeNetwork<int8_t>(bytes + 19, header.stage_index);
+        return frame;
+    }
+
+    static GatewayEnvelope decode(const zmq::message_t &frame)
+    {
+        if (frame.size() != SIZE)
+        {
+            throw std::invalid_argument(
+                std::format("gateway envelope size is invalid : {}",
+                            frame.size()));
+        }
+        auto *bytes = static_cast<const unsigned char *>(frame.data());
+
+        GatewayEnvelope envelope;
+        envelope.sid = BitConverter::loadNetwork<int64_t>(bytes);
+        envelope.type = static_cast<MessageType>(bytes[8]);
+        envelope.header.service_id =
+            BitConverter::loadNetwork<int16_t>(bytes + 9);
+        envelope.header.msg_id = BitConverter::loadNetwork<int32_t>(bytes + 11);
+        envelope.header.msg_seq =
+            BitConverter::loadNetwork<int16_t>(bytes + 15);
+        envelope.header.error_code =
+            BitConverter::loadNetwork<int16_t>(bytes + 17);
+        envelope.header.stage_index =
+            BitConverter::loadNetwork<int8_t>(bytes + 19);
+        return envelope;
+    }
+};
+
+struct GatewayConfig
+{
+    // backend router identity for each service_id
+    std::unordered_map<int16_t, std::string> routes;
+    // also tell every backend when sessions connect and disconnect
+    bool forwardSessionEvents = true;
+    // messages moved per direction and round
+    size_t batchSize = 256;
+};
+
+class GatewayStats
+{
+public:
+    static int64_t forwarded()
+    {
+        return _forwarded.load(std::memory_order_relaxed);
+    }
+
+    static int64_t returned()
+    {
+        return _returned.load(std::memory_order_relaxed);
+    }
+
+    static int64_t unroutable()
+    {
+        return _unroutable.load(std::memory_order_relaxed);
+    }
+
+    static void addForwarded(int64_t messages)
+    {
+        _forwarded.fetch_add(messages, std::memory_order_relaxed);
+    }
+
+    static void addReturned(int64_t messages)
+    {
+        _returned.fetch_add(messages, std::memory_order_relaxed);
+    }
+
+    static void addUnroutable()
+    {
+        _unroutable.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    inline static std::atomic<int64_t> _forwarded{0};
+    inline static std::atomic<int64_t> _returned{0};
+    inline static std::atomic<int64_t> _unroutable{0};
+};
+
+// Bridges a client-facing StreamSocket or WSStreamSocket to backends behind
+// a RouterSocket. Inbound client messages go to the backend identity routed
+// for their service_id, as [identity][GatewayEnvelope][body]; the body's
+// zmq::message_t is handed on as it is. Backends answer with
+// [gateway identity][envelope][reply frame], usually built with
+// RouterSocket::makeClientMessageBody(), and the reply frame goes to the
+// envelope's session, again without a copy until the client socket
+// writes it.
+//
+// The gateway needs the client socket's receive queue, so stage dispatch
+// must stay disabled there, and it owns the router socket while it runs.
+template <typename ClientSocket, typename BackendSocket = RouterSocket>
+class Gateway
+{
+public:
+    Gateway(std::shared_ptr<ClientSocket> clients,
+            BackendSocket &backends,
+            GatewayConfig config)
+        : _clients(std::move(clients)), _backends(backends),
+          _config(std::move(config)), _inbound(_config.batchSize),
+          _returns(_config.batchSize)
+    {
+    }
+
+    ~Gateway()
+    {
+        stop();
+    }
+
+    Gateway(const Gateway &) = delete;
+    Gateway &operator=(const Gateway &) = delete;
+
+    // forwards on a thread of its own until stop()
+    void start()
+    {
+        if (_running.exchange(true, std::memory_order_acq_rel))
+        {
+            return;
+        }
+        _thread = std::thread([this]() { run(); });
+    }
+
+    void stop()
+    {
+        if (_running.exchange(false, std::memory_order_acq_rel))
+        {
+            _thread.join();
+        }
+    }
+
+    // one round in both directions without waiting, for callers that
+    // drive the gateway from their own loop; returns the messages moved
+    size_t forward()
+    {
+        size_t moved = 0;
+
+        size_t count = _clients->recvBatch(_inbound, _inbound.size());
+        for (size_t i = 0; i < count; i++)
+        {
+            moved += forwardToBackend(*_inbound[i]);
+            _inbound[i].reset();
+        }
+
+        _backends.recvBatch(_returns,
+                            _returns.capacity(),
+                            std::chrono::milliseconds(0));
+        for (RouterMessage &message : _returns)
+        {
+            moved += returnToClient(message) ? 1 : 0;
+        }
+        return moved;
+    }
+
+    // sends one client message on to its backend; returns how many
+    // backend messages that took
+    size_t forwardToBackend(ClientMessage &message)
+    {
+        if (message.type() != MessageType::NORMAL)
+        {
+            return _config.forwardSessionEvents ? notifyBackends(message) : 0;
+        }
+
+        auto route = _config.routes.find(message.header().service_id);
+        if (route == _config.routes.end())
+        {
+            GatewayStats::addUnroutable();
+            Log::warn(std::format("no backend for service : {}",
+                                  message.header().service_id),
+                      typeid(this).name());
+            return 0;
+        }
+
+        GatewayEnvelope envelope;
+        envelope.sid = message.sid();
+        envelope.header.service_id = message.header().service_id;
+        envelope.header.msg_id = message.header().msg_id;
+        envelope.header.msg_seq = message.header().msg_seq;
+        envelope.header.stage_index = message.header().stage_index;
+
+        std::unique_ptr<zmq::message_t> body = message.body();
+        RouterMessage outbound(
+            zmq::message_t(route->second.data(), route->second.size()),
+            envelope.encode(),
+            body != nullptr ? std::move(*body) : zmq::message_t());
+        if (!send(outbound))
+        {
+            return 0;
+        }
+        GatewayStats::addForwarded(1);
+        return 1;
+    }
+
+    // sends one backend reply on to its session; false when it was
+    // malformed or the session is gone
+    bool returnToClient(RouterMessage &message)
+    {
+        GatewayEnvelope envelope;
+        try
+        {
+            envelope = GatewayEnvelope::decode(message.Header());
+        }
+        catch (std::invalid_argument &ex)
+        {
+            Log::error(ex.what(), typeid(this).name());
+            return false;
+        }
+
+        ClientMessage reply(
+            envelope.sid,
+            envelope.header,
+            std::make_unique<zmq::message_t>(std::move(message.body())));
+        if (_clients->send(std::move(reply)) != SendStatus::Queued)
+        {
+            return false;
+        }
+        GatewayStats::addReturned(1);
+        return true;
+    }
+
+private:
+    std::shared_ptr<ClientSocket> _clients;
+    BackendSocket &_backends;
+    GatewayConfig _config;
+
+    std::vector<std::unique_ptr<ClientMessage>> _inbound;
+    RouterMessageBatch _returns;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+
+    void run()
+    {
+        zmq::pollitem_t items[] = {
+            {_backends.handle(), 0, ZMQ_POLLIN, 0},
+            {nullptr, _clients->recvEventFd(), ZMQ_POLLIN, 0},
+        };
+        // without an eventfd, client messages wait for the poll timeout;
+        // with one, the timeout only bounds how long stop() takes
+        size_t itemCount = items[1].fd >= 0 ? 2 : 1;
+        auto timeout = items[1].fd >= 0 ? std::chrono::milliseconds(100)
+                                        : std::chrono::milliseconds(1);
+
+        while (_running.load(std::memory_order_acquire))
+        {
+            try
+            {
+                if (forward() == 0)
+                {
+                    zmq::poll(items, itemCount, timeout);
+                }
+            }
+            catch (zmq::error_t &ex)
+            {
+                Log::error(std::format("gateway error : {}", ex.what()),
+                           typeid(this).name());
+            }
+        }
+    }
+
+    size_t notifyBackends(const ClientMessage &message)
+    {
+        GatewayEnvelope envelope;
+        envelope.sid = message.sid();
+        envelope.type = message.type();
+
+        std::vector<const std::string *> notified;
+        size_t sent = 0;
+        for (const auto &[serviceId, identity] : _config.routes)
+        {
+            // several services can share one backend
+            if (std::any_of(notified.begin(),
+                            notified.end(),
+                            [&identity](const std::string *other) {
+                                return *other == identity;
+                            }))
+            {
+                continue;
+            }
+            notified.push_back(&identity);
+
+            RouterMessage event(
+                zmq::message_t(identity.data(), identity.size()),
+                envelope.encode(),
+                zmq::message_t());
+            sent += send(event) ? 1 : 0;
+        }
+        return sent;
+    }
+
+    bool send(RouterMessage &message)
+    {
+        try
+        {
+            return _backends.send(message);
+        }
+        catch (zmq::error_t &ex)
+        {
+            // the backend is not connected, with router_mandatory set
+            Log::error(std::format("gateway send failed : {}", ex.what()),
+                       typeid(this).name());
+            return false;
+        }
+    }
+};
+
+} // namespace Play
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "bit_converter.hpp"
+#include "client_message.hpp"
+
+namespace Play
+{
+
+// the largest body a frame's uint16 size field describes
+const int MAX_PACKET_SIZE = 65535;
+
+// Header of a server-to-client frame, which carries an error code the client
+// requests do not.
+struct ReplyHeader : Header
+{
+    int16_t error_code = 0;
+};
+
+// One header field: the member it maps to, written big-endian. A disabled
+// field takes no bytes and is never touched, so a layout can switch it on
+// for one variant without the other variant's type having the member.
+template <auto Member, bool Enabled = true>
+struct HeaderField;
+
+template <typename Owner, typename T, T Owner::*Member, bool Enabled>
+struct HeaderField<Member, Enabled>
+{
+    using value_type = T;
+    static constexpr size_t SIZE = Enabled ? sizeof(T) : 0;
+
+    template <typename Value>
+    static void decode(Value &value, const unsigned char *source)
+    {
+        if constexpr (Enabled)
+        {
+            value.*Member = BitConverter::loadNetwork<T>(source);
+        }
+    }
+
+    template <typename Value>
+    static void encode(const Value &value, unsigned char *destination)
+    {
+        if constexpr (Enabled)
+        {
+            BitConverter::storeNetwork<T>(destination, value.*Member);
+        }
+    }
+};
+
+// Frame header layout: a big-endian uint16 body size followed by `Fields` in
+// order. The encoder and decoder are both generated from the field list.
+template <typename Value, typename... Fields>
+class HeaderCodec
+{
+public:
+    using value_type = Value;
+
+    static constexpr size_t BODY_SIZE_BYTES = sizeof(uint16_t);
+    static constexpr size_t SIZE = BODY_SIZE_BYTES + (Fields::SIZE + ...);
+
+    static uint16_t peekBodySize(const unsigned char *frame)
+    {
+        return BitConverter::loadNetwork<uint16_t>(frame);
+    }
+
+    static Value decode(const unsigned char *frame)
+    {
+        Value value{};
+        size_t offset = BODY_SIZE_BYTES;
+        ((Fields::decode(value, frame + offset), offset += Fields::SIZE), ...);
+        return value;
+    }
+
+    static void encode(unsigned char *frame,
+                       uint16_t bodySize,
+                       const Value &value)
+    {
+        BitConverter::storeNetwork<uint16_t>(frame, bodySize);
+        size_t offset = BODY_SIZE_BYTES;
+        ((Fields::encode(value, frame + offset), offset += Fields::SIZE), ...);
+    }
+};
+
+// The one definition of the wire header; the reply variant inserts the error
+// code between msg_seq and stage_index.
+template <bool WithErrorCode>
+using FrameHeaderCodec =
+    HeaderCodec<std::conditional_t<WithErrorCode, ReplyHeader, Header>,
+                HeaderField<&Header::service_id>,
+                HeaderField<&Header::msg_id>,
+                HeaderField<&Header::msg_seq>,
+                HeaderField<&ReplyHeader::error_code, WithErrorCode>,
+                HeaderField<&Header::stage_index>>;
+
+using ClientHeaderCodec = FrameHeaderCodec<false>;
+using ReplyHeaderCodec = FrameHeaderCodec<true>;
+
+static_assert(ClientHeaderCodec::SIZE == 11);
+static_assert(ReplyHeaderCodec::SIZE == 13);
+
+} // namespace Play
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "outbound_queue.hpp"
+#include "shared_payload.hpp"
+#include "timer_wheel.hpp"
+
+namespace Play
+{
+
+// When sessions count as dead and when the server pings them.
+struct IdlePolicy
+{
+    // sessions that receive nothing for this long are disconnected, zero
+    // disables the check
+    std::chrono::milliseconds idleTimeout{0};
+    // sessions the server sent nothing to for this long get `heartbeat`,
+    // zero disables heartbeats
+    std::chrono::milliseconds heartbeatInterval{0};
+    // resolution of both; deadlines are rounded up to whole ticks
+    std::chrono::milliseconds tick{100};
+    // sent as it is, like the body passed to send()
+    std::vector<unsigned char> heartbeat;
+};
+
+// Last activity of a session in IdleMonitor ticks. I/O paths only store the
+// monitor's current tick here, so a reset is a load and a store.
+struct SessionActivity
+{
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> sent{0};
+};
+
+class IdleStats
+{
+public:
+    static int64_t idleDisconnects()
+    {
+        return _idleDisconnects.load(std::memory_order_relaxed);
+    }
+
+    static int64_t heartbeats()
+    {
+        return _heartbeats.load(std::memory_order_relaxed);
+    }
+
+    static void addIdleDisconnect()
+    {
+        _idleDisconnects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void addHeartbeat()
+    {
+        _heartbeats.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    inline static std::atomic<int64_t> _idleDisconnects{0};
+    inline static std::atomic<int64_t> _heartbeats{0};
+};
+
+// Idle detection and heartbeats for every session of a socket on one
+// TimerWheel, instead of a timer per session. Each session sits in the
+// wheel once, at its next deadline. Activity only updates the session's
+// SessionActivity; when the entry fires, the monitor works out from those
+// stamps whether the session is idle, needs a heartbeat, or simply moves on
+// to its new deadline.
+//
+// `Session` needs `SessionActivity &activity()`, `Disconnect()` and
+// `send(const SharedPayload &, SendClass)`.
+template <typename Session>
+class IdleMonitor
+{
+public:
+    explicit IdleMonitor(const IdlePolicy &policy = {})
+        : _start(std::chrono::steady_clock::now())
+    {
+        setPolicy(policy);
+    }
+
+    // must be called before sessions are tracked
+    void setPolicy(const IdlePolicy &policy)
+    {
+        if (policy.tick <= std::chrono::milliseconds(0))
+        {
+            throw std::invalid_argument(
+                std::format("idle tick must be positive : {}ms",
+                            policy.tick.count()));
+        }
+        _policy = policy;
+        _idleTicks = ticksOf(policy.idleTimeout);
+        _heartbeatTicks = ticksOf(policy.heartbeatInterval);
+        _heartbeat = SharedPayload(std::span<const unsigned char>(
+            policy.heartbeat.data(),
+            policy.heartbeat.size()));
+    }
+
+    bool enabled() const
+    {
+        return _idleTicks > 0 || _heartbeatTicks > 0;
+    }
+
+    std::chrono::milliseconds tick() const
+    {
+        return _policy.tick;
+    }
+
+    // the tick sessions stamp their activity with
+    uint64_t now() const
+    {
+        return _now.load(std::memory_order_relaxed);
+    }
+
+    // starts watching a newly connected session
+    void track(int64_t sid, SessionActivity &activity)
+    {
+        uint64_t now = this->now();
+        activity.received.store(now, std::memory_order_relaxed);
+        activity.sent.store(now, std::memory_order_relaxed);
+        if (!enabled())
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        _wheel.schedule(sid, nextDeadline(now, now));
+    }
+
+    // moves the clock to `time` and handles the sessions that came due;
+    // find(sid) returns a raw or shared pointer to the session, or nullptr
+    // once it is gone
+    template <typename Find>
+    void advance(std::chrono::steady_clock::time_point time, Find &&find)
+    {
+        uint64_t now = static_cast<uint64_t>((time - _start) / _policy.tick);
+        _now.store(now, std::memory_order_relaxed);
+
+        _due.clear();
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _wheel.advance(now, [this](int64_t sid, uint64_t) {
+                _due.push_back(sid);
+            });
+        }
+
+        // sessions are disconnected and sent to outside the lock, so their
+        // callbacks may track other sessions
+        _rescheduled.clear();
+        for (int64_t sid : _due)
+        {
+            auto session = find(sid);
+            if (session == nullptr)
+            {
+                continue;
+            }
+            SessionActivity &activity = session->activity();
+            uint64_t received =
+                activity.received.load(std::memory_order_relaxed);
+
+            if (_idleTicks > 0 && now - received >= _idleTicks)
+            {
+                IdleStats::addIdleDisconnect();
+                session->Disconnect();
+                continue;
+            }
+
+            uint64_t sent = activity.sent.load(std::memory_order_relaxed);
+            if (_heartbeatTicks > 0 && now - sent >= _heartbeatTicks)
+            {
+                session->send(_heartbeat, SendClass::Droppable);
+                IdleStats::addHeartbeat();
+                sent = now;
+                activity.sent.store(now, std::memory_order_relaxed);
+            }
+            _rescheduled.push_back({sid, nextDeadline(received, sent)});
+        }
+
+        std::lock_guard<std::mutex> lock(_lock);
+        for (const auto &[sid, deadline] : _rescheduled)
+        {
+            _wheel.schedule(sid, deadline);
+        }
+    }
+
+    size_t tracked()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _wheel.size();
+    }
+
+private:
+    IdlePolicy _policy{};
+    SharedPayload _heartbeat;
+    uint64_t _idleTicks = 0;
+    uint64_t _heartbeatTicks = 0;
+    std::chrono::steady_clock::time_point _start;
+    std::atomic<uint64_t> _now{0};
+
+    std::mutex _lock;
+    TimerWheel<int64_t> _wheel;
+    // scratch for advance(), which only the timer calls
+    std::vector<int64_t> _due;
+    std::vector<std::pair<int64_t, uint64_t>> _rescheduled;
+
+    uint64_t ticksOf(std::chrono::milliseconds duration) const
+    {
+        if (duration.count() <= 0)
+        {
+            return 0;
+        }
+        return static_cast<uint64_t>(
+            (duration + _policy.tick - std::chrono::milliseconds(1)) /
+            _policy.tick);
+    }
+
+    uint64_t nextDeadline(uint64_t received, uint64_t sent) const
+    {
+        uint64_t deadline = UINT64_MAX;
+        if (_idleTicks > 0)
+        {
+            deadline = std::min(deadline, received + _idleTicks);
+        }
+        if (_heartbeatTicks > 0)
+        {
+            deadline = std::min(deadline, sent + _heartbeatTicks);
+        }
+        return deadline;
+    }
+};
+
+} // namespace Play
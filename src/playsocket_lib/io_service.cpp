@@ -0,0 +1,79 @@
+#include "io_service.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include "logger_interface.hpp"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace Play;
+
+namespace
+{
+
+thread_local int ioThreadIndex = -1;
+
+} // namespace
+
+IoService::IoService(const IoConfig &config)
+    : CppServer::Asio::Service(std::max(config.threads, 1),
+                               config.threads > 1),
+      _config(config)
+{
+}
+
+int IoService::currentThread()
+{
+    return ioThreadIndex;
+}
+
+void IoService::onThreadInitialize()
+{
+    // a restarted service numbers its threads from where it left off
+    int thread = _nextThread.fetch_add(1, std::memory_order_relaxed) %
+                 std::max(_config.threads, 1);
+    ioThreadIndex = thread;
+
+    if (_config.pinThreads)
+    {
+        pin(thread);
+    }
+}
+
+void IoService::onThreadCleanup()
+{
+    ioThreadIndex = -1;
+}
+
+void IoService::pin(int thread)
+{
+    int cpu = _config.cpus.empty()
+                  ? thread
+                  : _config.cpus[thread % _config.cpus.size()];
+
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0)
+    {
+        Log::error(std::format("pinning io thread failed: "
+                               "thread:{},cpu:{},error:{}",
+                               thread,
+                               cpu,
+                               result),
+                   typeid(this).name());
+    }
+#else
+    Log::warn(std::format("io thread pinning is not supported here: "
+                          "thread:{},cpu:{}",
+                          thread,
+                          cpu),
+              typeid(this).name());
+#endif
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <server/asio/service.h>
+#include <vector>
+
+namespace Play
+{
+
+struct IoConfig
+{
+    // I/O threads; with more than one, every thread runs its own Asio
+    // service and a session stays on the thread that accepted it
+    int threads = 1;
+    // pins I/O thread i to cpus[i % cpus.size()], or to CPU i when empty
+    bool pinThreads = false;
+    std::vector<int> cpus;
+};
+
+struct ListenConfig
+{
+    // listeners opened on the port, each with SO_REUSEPORT so the kernel
+    // spreads new connections over them; 0 opens one per I/O thread
+    int acceptors = 1;
+    // sets SO_REUSEPORT even on a single listener, so that pre-forked
+    // processes of the same user can bind the same port
+    bool reusePort = false;
+
+    int acceptorCount(const IoConfig &io) const
+    {
+        return acceptors > 0 ? acceptors : std::max(io.threads, 1);
+    }
+
+    bool sharesPort(const IoConfig &io) const
+    {
+        return reusePort || acceptorCount(io) > 1;
+    }
+};
+
+// Asio service that numbers its threads, so sessions can pick the receive
+// shard of the thread they run on, and optionally pins them to CPUs.
+class IoService : public CppServer::Asio::Service
+{
+private:
+    IoConfig _config;
+    std::atomic<int> _nextThread{0};
+
+public:
+    explicit IoService(const IoConfig &config);
+
+    // index of the calling I/O thread within its service, -1 elsewhere
+    static int currentThread();
+
+protected:
+    void onThreadInitialize() override;
+    void onThreadCleanup() override;
+
+private:
+    void pin(int thread);
+};
+
+} // namespace Play
@@ -0,0 +1,511 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Play
+{
+
+// Ring buffers that can expose every readable byte as one contiguous range.
+template <typename Buffer>
+concept ContiguousRingBuffer = requires(const Buffer &buffer) {
+    {
+        buffer.data()
+    } -> std::convertible_to<const unsigned char *>;
+};
+
+// Maps the same pages twice back-to-back so that [index, index + size) is
+// contiguous for any index inside the first half. Where memfd_create/mmap is
+// unavailable the region falls back to a heap block of twice the size whose
+// halves are kept identical by writing every byte to both of them.
+class MirroredRegion
+{
+public:
+    MirroredRegion() = default;
+
+    explicit MirroredRegion(size_t size)
+    {
+        _size = std::max<size_t>(size, 1);
+#if defined(__linux__)
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t mappedSize = (_size + pageSize - 1) / pageSize * pageSize;
+        _data = mapMirror(mappedSize);
+        if (_data != nullptr)
+        {
+            _size = mappedSize;
+            _mapped = true;
+            return;
+        }
+#endif
+        _data = new unsigned char[_size * 2];
+    }
+
+    MirroredRegion(const MirroredRegion &) = delete;
+    MirroredRegion &operator=(const MirroredRegion &) = delete;
+
+    MirroredRegion(MirroredRegion &&other) noexcept
+        : _data(std::exchange(other._data, nullptr)),
+          _size(std::exchange(other._size, 0)),
+          _mapped(std::exchange(other._mapped, false))
+    {
+    }
+
+    MirroredRegion &operator=(MirroredRegion &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+            _mapped = std::exchange(other._mapped, false);
+        }
+        return *this;
+    }
+
+    ~MirroredRegion()
+    {
+        release();
+    }
+
+    unsigned char *data() const
+    {
+        return _data;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool isMapped() const
+    {
+        return _mapped;
+    }
+
+    // index must lie in the first half and count must not exceed size()
+    void store(size_t index, const unsigned char *source, size_t count)
+    {
+        if (_mapped)
+        {
+            std::memcpy(_data + index, source, count);
+            return;
+        }
+
+        size_t first = std::min(count, _size - index);
+        std::memcpy(_data + index, source, first);
+        std::memcpy(_data + index + _size, source, first);
+        std::memcpy(_data, source + first, count - first);
+        std::memcpy(_data + _size, source + first, count - first);
+    }
+
+    // copies bytes written in place into the first half over to the second
+    // half; the mapped mirror already aliases them
+    void mirror(size_t index, size_t count)
+    {
+        if (_mapped)
+        {
+            return;
+        }
+
+        size_t first = std::min(count, _size - index);
+        std::memcpy(_data + index + _size, _data + index, first);
+        std::memcpy(_data + _size, _data, count - first);
+    }
+
+private:
+    unsigned char *_data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;
+
+    void release()
+    {
+        if (_data == nullptr)
+        {
+            return;
+        }
+#if defined(__linux__)
+        if (_mapped)
+        {
+            munmap(_data, _size * 2);
+            _data = nullptr;
+            return;
+        }
+#endif
+        delete[] _data;
+        _data = nullptr;
+    }
+
+#if defined(__linux__)
+    static unsigned char *mapMirror(size_t size)
+    {
+        int fd = memfd_create("playsocket_ring", MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        // reserve both halves first so the fixed mappings cannot clobber
+        // anything else in the address space
+        void *base = mmap(nullptr,
+                          size * 2,
+                          PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+        if (base == MAP_FAILED)
+        {
+            ::close(fd);
+            return nullptr;
+        }
+
+        auto *bytes = static_cast<unsigned char *>(base);
+        void *first = mmap(bytes,
+                           size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED,
+                           fd,
+                           0);
+        void *second = mmap(bytes + size,
+                            size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_FIXED,
+                            fd,
+                            0);
+        // the mappings keep the memory alive, the descriptor is not needed
+        ::close(fd);
+
+        if (first != bytes || second != bytes + size)
+        {
+            munmap(base, size * 2);
+            return nullptr;
+        }
+        return bytes;
+    }
+#endif
+};
+
+class MirroredRingBuffer
+{
+public:
+    explicit MirroredRingBuffer(size_t capacity, size_t maxCapacity)
+        : _region(capacity), _readerIndex(0), _headerIndex(0), _size(0),
+          _capacity(capacity), _maxCapacity(maxCapacity)
+    {
+        if (capacity > maxCapacity)
+        {
+            throw std::invalid_argument(
+                "capacity cannot be greater than maxCapacity");
+        }
+    }
+
+    MirroredRingBuffer(size_t capacity) : MirroredRingBuffer(capacity, capacity)
+    {
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool isMirrored() const
+    {
+        return _region.isMapped();
+    }
+
+    // the mapped mirror shares its pages, the heap fallback holds both halves
+    size_t allocatedBytes() const
+    {
+        return _region.isMapped() ? _region.size() : _region.size() * 2;
+    }
+
+    // all readable bytes, contiguous even when they straddle the wrap point
+    const unsigned char *data() const
+    {
+        return _region.data() + _readerIndex;
+    }
+
+    std::span<const unsigned char> readable() const
+    {
+        return {data(), _size};
+    }
+
+    void push(unsigned char item)
+    {
+        write(&item, 0, 1);
+    }
+
+    void push(const std::vector<unsigned char> &data)
+    {
+        write(data.data(), 0, data.size());
+    }
+
+    void resizeBuffer(size_t newCapacity)
+    {
+        if (newCapacity > _maxCapacity)
+        {
+            throw std::out_of_range("Queue has reached maximum capacity");
+        }
+        if (newCapacity < _size)
+        {
+            throw std::invalid_argument("capacity cannot be less than size");
+        }
+
+        if (newCapacity > _region.size() || newCapacity < _capacity)
+        {
+            MirroredRegion region(newCapacity);
+            region.store(0, data(), _size);
+
+            _region = std::move(region);
+            _readerIndex = 0;
+            _headerIndex = advanceIndex(0, _size);
+        }
+        _capacity = newCapacity;
+    }
+
+    unsigned char pop()
+    {
+        unsigned char item = peek();
+        clear(1);
+        return item;
+    }
+
+    unsigned char peek() const
+    {
+        if (_size == 0)
+        {
+            throw std::runtime_error("Queue is empty");
+        }
+
+        return *data();
+    }
+
+    void clear()
+    {
+        _readerIndex = 0;
+        _headerIndex = 0;
+        _size = 0;
+    }
+
+    void release()
+    {
+        if (_size != 0)
+        {
+            throw std::logic_error("cannot release a non-empty buffer");
+        }
+
+        _region = MirroredRegion();
+        _capacity = 0;
+        _readerIndex = 0;
+        _headerIndex = 0;
+    }
+
+    void clear(size_t count)
+    {
+        if (count > _size)
+        {
+            throw std::invalid_argument("count exceeds queue size");
+        }
+
+        _readerIndex = advanceIndex(_readerIndex, count);
+        _size -= count;
+    }
+
+    size_t read(unsigned char *buffer, size_t offset, size_t count)
+    {
+        size_t bytesRead = std::min(count, _size);
+
+        if (bytesRead > 0)
+        {
+            std::memcpy(buffer + offset, data(), bytesRead);
+        }
+        clear(bytesRead);
+
+        return bytesRead;
+    }
+
+    void write(const unsigned char *buffer, size_t offset, size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        ensureCapacity(_size + count);
+        _region.store(_headerIndex, buffer + offset, count);
+        _headerIndex = advanceIndex(_headerIndex, count);
+        _size += count;
+    }
+
+    void write(const std::span<const unsigned char> &buffer)
+    {
+        write(buffer.data(), 0, buffer.size());
+    }
+
+    // same shape as RingBuffer::readableSpans, the second span is always empty
+    std::array<std::span<const unsigned char>, 2> readableSpans() const
+    {
+        return {readable(), std::span<const unsigned char>()};
+    }
+
+    std::array<std::span<unsigned char>, 2> writableSpans(size_t minimum = 0)
+    {
+        ensureCapacity(_size + minimum);
+
+        unsigned char *base = _region.data();
+        size_t free = capacity() - _size;
+        size_t first = _region.isMapped()
+                           ? free
+                           : std::min(free, _region.size() - _headerIndex);
+        return {std::span<unsigned char>(base + _headerIndex, first),
+                std::span<unsigned char>(base, free - first)};
+    }
+
+    void commitWrite(size_t count)
+    {
+        if (count > capacity() - _size)
+        {
+            throw std::invalid_argument("count exceeds writable space");
+        }
+
+        _region.mirror(_headerIndex, count);
+        _headerIndex = advanceIndex(_headerIndex, count);
+        _size += count;
+    }
+
+    void consume(size_t count)
+    {
+        clear(count);
+    }
+
+    int8_t readInt8()
+    {
+        return pop();
+    }
+
+    int16_t readInt16()
+    {
+        int16_t data = peekInt16();
+        clear(sizeof(int16_t));
+        return data;
+    }
+
+    int32_t readInt32()
+    {
+        int32_t data = peekInt32();
+        clear(sizeof(int32_t));
+        return data;
+    }
+
+    int16_t peekInt16() const
+    {
+        const unsigned char *bytes = peekBytes(sizeof(int16_t));
+        return static_cast<int16_t>((bytes[0] << 8) | bytes[1]);
+    }
+
+    int32_t peekInt32() const
+    {
+        const unsigned char *bytes = peekBytes(sizeof(int32_t));
+        return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+    }
+
+    void write(uint16_t value)
+    {
+        unsigned char bytes[] = {
+            static_cast<unsigned char>((value >> 8) & 0xFF),
+            static_cast<unsigned char>(value & 0xFF)};
+        write(bytes, 0, sizeof(bytes));
+    }
+
+    void write(uint32_t value)
+    {
+        unsigned char bytes[] = {
+            static_cast<unsigned char>((value >> 24) & 0xFF),
+            static_cast<unsigned char>((value >> 16) & 0xFF),
+            static_cast<unsigned char>((value >> 8) & 0xFF),
+            static_cast<unsigned char>(value & 0xFF)};
+        write(bytes, 0, sizeof(bytes));
+    }
+
+    void write(int16_t value)
+    {
+        write(static_cast<uint16_t>(value));
+    }
+
+    void write(int32_t value)
+    {
+        write(static_cast<uint32_t>(value));
+    }
+
+    void write(uint8_t value)
+    {
+        push(value);
+    }
+
+    void write(int8_t value)
+    {
+        push(static_cast<unsigned char>(value));
+    }
+
+private:
+    MirroredRegion _region;
+    size_t _readerIndex;
+    size_t _headerIndex;
+    size_t _size;
+    size_t _capacity;
+    size_t _maxCapacity;
+
+    // indices wrap at the region size, which may be larger than the logical
+    // capacity once it has been rounded up to whole pages
+    size_t advanceIndex(size_t index, size_t count) const
+    {
+        index += count;
+        return index >= _region.size() ? index - _region.size() : index;
+    }
+
+    void ensureCapacity(size_t required)
+    {
+        if (required <= capacity())
+        {
+            return;
+        }
+
+        size_t newCapacity = std::max<size_t>(capacity(), 1);
+        while (newCapacity < required)
+        {
+            newCapacity *= 2;
+        }
+        resizeBuffer(newCapacity);
+    }
+
+    const unsigned char *peekBytes(size_t count) const
+    {
+        if (_size < count)
+        {
+            throw std::out_of_range("Index out of range");
+        }
+        return data();
+    }
+};
+
+} // namespace Play
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace Play
+{
+
+// Lock-free pool of fixed-size slots for class-level operator new/delete.
+// Slots live in slabs that are allocated on demand and only freed with the
+// pool, so a slot index stays valid for the pool's lifetime; a pool that
+// must outlive late deallocations, like the process-wide one, is leaked on
+// purpose. Free slots form a Treiber stack whose head packs a 32-bit ABA
+// tag with the slot index. Once every slab is in use further allocations
+// fall back to the heap.
+template <size_t SlotSize, size_t SlotAlign>
+class ObjectPool
+{
+public:
+    static constexpr uint32_t SLAB_SLOTS = 1024;
+    static constexpr uint32_t MAX_SLABS = 4096;
+
+    ObjectPool() = default;
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    // every slot must have been deallocated by now
+    ~ObjectPool()
+    {
+        uint32_t slabs = _slabCount.load(std::memory_order_acquire);
+        for (uint32_t i = 0; i < slabs; i++)
+        {
+            delete[] _slabs[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    void *allocate()
+    {
+        Slot *slot = pop();
+        if (slot == nullptr)
+        {
+            slot = grow();
+        }
+        return slot->storage;
+    }
+
+    void deallocate(void *pointer)
+    {
+        if (pointer == nullptr)
+        {
+            return;
+        }
+
+        Slot *slot = slotOf(pointer);
+        if (slot->index == HEAP_SLOT)
+        {
+            _heapSlots.fetch_sub(1, std::memory_order_relaxed);
+            delete slot;
+            return;
+        }
+        push(slot);
+    }
+
+    // slots carved out of slabs so far
+    size_t capacity() const
+    {
+        return static_cast<size_t>(
+                   _slabCount.load(std::memory_order_acquire)) *
+               SLAB_SLOTS;
+    }
+
+    // live slots that did not fit in the slabs
+    int64_t heapSlots() const
+    {
+        return _heapSlots.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uint32_t HEAP_SLOT = UINT32_MAX;
+
+    struct Slot
+    {
+        alignas(SlotAlign) unsigned char storage[SlotSize];
+        uint32_t index = HEAP_SLOT;
+        std::atomic<uint32_t> next{0};
+    };
+
+    std::array<std::atomic<Slot *>, MAX_SLABS> _slabs{};
+    std::atomic<uint32_t> _slabCount{0};
+    std::mutex _growLock;
+    // tag << 32 | (slot index + 1), with 0 as the empty stack
+    std::atomic<uint64_t> _head{0};
+    std::atomic<int64_t> _heapSlots{0};
+
+    static Slot *slotOf(void *pointer)
+    {
+        // storage is the first member, so the slot shares its address
+        return reinterpret_cast<Slot *>(pointer);
+    }
+
+    Slot *slotAt(uint32_t index) const
+    {
+        Slot *slab =
+            _slabs[index / SLAB_SLOTS].load(std::memory_order_acquire);
+        return slab + index % SLAB_SLOTS;
+    }
+
+    Slot *pop()
+    {
+        uint64_t head = _head.load(std::memory_order_acquire);
+        while (static_cast<uint32_t>(head) != 0)
+        {
+            Slot *slot = slotAt(static_cast<uint32_t>(head) - 1);
+            // the slot may be popped and pushed again meanwhile; the tag
+            // makes the exchange below fail in that case
+            uint32_t next = slot->next.load(std::memory_order_relaxed);
+            uint64_t tag = (head >> 32) + 1;
+            if (_head.compare_exchange_weak(head,
+                                            tag << 32 | next,
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire))
+            {
+                return slot;
+            }
+        }
+        return nullptr;
+    }
+
+    void push(Slot *slot)
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        uint64_t tag;
+        do
+        {
+            slot->next.store(static_cast<uint32_t>(head),
+                             std::memory_order_relaxed);
+            tag = (head >> 32) + 1;
+        } while (!_head.compare_exchange_weak(head,
+                                              tag << 32 | (slot->index + 1),
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed));
+    }
+
+    // adds a slab and returns one of its slots, pushing the rest; falls back
+    // to a heap slot when the slabs are exhausted
+    Slot *grow()
+    {
+        std::lock_guard<std::mutex> lock(_growLock);
+
+        // another thread may have grown the pool while this one waited
+        if (Slot *slot = pop())
+        {
+            return slot;
+        }
+
+        uint32_t slabIndex = _slabCount.load(std::memory_order_relaxed);
+        if (slabIndex == MAX_SLABS)
+        {
+            _heapSlots.fetch_add(1, std::memory_order_relaxed);
+            return new Slot();
+        }
+
+        auto slab = std::make_unique<Slot[]>(SLAB_SLOTS);
+        uint32_t first = slabIndex * SLAB_SLOTS;
+        for (uint32_t i = 0; i < SLAB_SLOTS; i++)
+        {
+            slab[i].index = first + i;
+        }
+
+        Slot *slots = slab.release();
+        _slabs[slabIndex].store(slots, std::memory_order_release);
+        _slabCount.store(slabIndex + 1, std::memory_order_release);
+
+        for (uint32_t i = 1; i < SLAB_SLOTS; i++)
+        {
+            push(&slots[i]);
+        }
+        return &slots[0];
+    }
+};
+
+} // namespace Play
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#include "shared_payload.hpp"
+
+namespace Play
+{
+
+// What happens to a message a slow session cannot take any more.
+enum class BackpressureAction
+{
+    // reject new messages until the session has drained
+    DropNewest,
+    // hold new messages back, up to another high watermark's worth, and
+    // evict the oldest droppable ones to make room
+    DropOldest,
+    // disconnect the session
+    Disconnect
+};
+
+// How much outbound data a session may queue before the action applies.
+struct SendBackpressurePolicy
+{
+    // queued bytes above which the action applies, zero disables the limit
+    size_t highWatermark = 0;
+    // a throttled session takes messages normally again once its queued
+    // bytes fall to this
+    size_t lowWatermark = 0;
+    BackpressureAction action = BackpressureAction::DropNewest;
+};
+
+// Whether a message may be given up under BackpressureAction::DropOldest.
+enum class SendClass
+{
+    Normal,
+    Droppable
+};
+
+enum class SendStatus
+{
+    // written, staged for a coalesced write, or held back for later
+    Queued,
+    Dropped,
+    // the session went over its limit and is being disconnected
+    Disconnected,
+    UnknownSession
+};
+
+// Process-wide gauges of outbound data waiting on slow sessions.
+class OutboundStats
+{
+public:
+    // bytes handed to the sessions' sockets and not yet sent
+    static int64_t queuedBytes()
+    {
+        return _queuedBytes.load(std::memory_order_relaxed);
+    }
+
+    // bytes held back by throttled sessions
+    static int64_t heldBytes()
+    {
+        return _heldBytes.load(std::memory_order_relaxed);
+    }
+
+    static int64_t droppedMessages()
+    {
+        return _droppedMessages.load(std::memory_order_relaxed);
+    }
+
+    static int64_t disconnects()
+    {
+        return _disconnects.load(std::memory_order_relaxed);
+    }
+
+    static void addQueued(int64_t bytes)
+    {
+        _queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static void addHeld(int64_t bytes)
+    {
+        _heldBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static void addDropped(int64_t messages)
+    {
+        _droppedMessages.fetch_add(messages, std::memory_order_relaxed);
+    }
+
+    static void addDisconnect()
+    {
+        _disconnects.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    inline static std::atomic<int64_t> _queuedBytes{0};
+    inline static std::atomic<int64_t> _heldBytes{0};
+    inline static std::atomic<int64_t> _droppedMessages{0};
+    inline static std::atomic<int64_t> _disconnects{0};
+};
+
+// Applies a SendBackpressurePolicy to one session's outbound messages.
+// `pending` is what the session's socket has not sent yet. While it stays
+// under the high watermark messages are written straight through; past it
+// the session is throttled until release() sees it drained to the low
+// watermark; call release() from the socket's send completions and before
+// each submit(). Writes happen under the queue's lock so that held messages
+// and new ones reach the socket in order.
+class OutboundQueue
+{
+private:
+    struct Held
+    {
+        SharedPayload payload;
+        size_t size;
+        bool droppable;
+    };
+
+    std::mutex _lock;
+    std::deque<Held> _held;
+    size_t _heldBytes = 0;
+    bool _throttled = false;
+
+public:
+    OutboundQueue() = default;
+    OutboundQueue(const OutboundQueue &) = delete;
+    OutboundQueue &operator=(const OutboundQueue &) = delete;
+
+    ~OutboundQueue()
+    {
+        clear();
+    }
+
+    // write() sends the message now; payload() returns a SharedPayload of
+    // it, only called when the message is held back
+    template <typename Write, typename Payload>
+    SendStatus submit(size_t size,
+                      SendClass sendClass,
+                      size_t pending,
+                      const SendBackpressurePolicy &policy,
+                      Write &&write,
+                      Payload &&payload)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (policy.highWatermark == 0)
+        {
+            write();
+            return SendStatus::Queued;
+        }
+
+        if (!_throttled)
+        {
+            // a message larger than the whole budget still goes out alone
+            if (pending + size <= policy.highWatermark || pending == 0)
+            {
+                write();
+                return SendStatus::Queued;
+            }
+            _throttled = true;
+        }
+
+        bool droppable = sendClass == SendClass::Droppable;
+        switch (policy.action)
+        {
+        case BackpressureAction::DropNewest:
+            OutboundStats::addDropped(1);
+            return SendStatus::Dropped;
+
+        case BackpressureAction::Disconnect:
+            OutboundStats::addDisconnect();
+            return SendStatus::Disconnected;
+
+        case BackpressureAction::DropOldest:
+            while (_heldBytes + size > policy.highWatermark &&
+                   evictOldestDroppable())
+            {
+            }
+            if (_heldBytes + size <= policy.highWatermark)
+            {
+                _held.push_back({payload(), size, droppable});
+                _heldBytes += size;
+                OutboundStats::addHeld(static_cast<int64_t>(size));
+                return SendStatus::Queued;
+            }
+            if (droppable)
+            {
+                OutboundStats::addDropped(1);
+                return SendStatus::Dropped;
+            }
+            // a message that must not be lost does not fit any more
+            OutboundStats::addDisconnect();
+            return SendStatus::Disconnected;
+        }
+        return SendStatus::Dropped;
+    }
+
+    // ends throttling once `pending` has fallen to the low watermark,
+    // writing held messages through write(const SharedPayload &); returns
+    // the bytes written, which are pending from then on
+    template <typename Write>
+    size_t release(size_t pending,
+                   const SendBackpressurePolicy &policy,
+                   Write &&write)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        if (!_throttled || pending > policy.lowWatermark)
+        {
+            return 0;
+        }
+
+        size_t released = 0;
+        for (const Held &held : _held)
+        {
+            write(held.payload);
+            released += held.size;
+        }
+        forgetHeld();
+        _throttled = false;
+        return released;
+    }
+
+    // forgets held messages, for a disconnected session
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        forgetHeld();
+        _throttled = false;
+    }
+
+    bool throttled()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _throttled;
+    }
+
+    size_t heldBytes()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _heldBytes;
+    }
+
+private:
+    bool evictOldestDroppable()
+    {
+        for (auto it = _held.begin(); it != _held.end(); ++it)
+        {
+            if (it->droppable)
+            {
+                _heldBytes -= it->size;
+                OutboundStats::addHeld(-static_cast<int64_t>(it->size));
+                OutboundStats::addDropped(1);
+                _held.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void forgetHeld()
+    {
+        OutboundStats::addHeld(-static_cast<int64_t>(_heldBytes));
+        _held.clear();
+        _heldBytes = 0;
+    }
+};
+
+} // namespace Play
@@ -0,0 +1,43 @@
+#include "periodic_timer.hpp"
+
+#include "logger_interface.hpp"
+
+using namespace Play;
+
+PeriodicTimer::PeriodicTimer(
+    const std::shared_ptr<CppServer::Asio::Service> &service,
+    std::chrono::microseconds interval,
+    std::function<void()> action)
+    : CppServer::Asio::Timer(service), _interval(interval),
+      _action(std::move(action))
+{
+}
+
+void PeriodicTimer::start()
+{
+    Setup(CppCommon::Timespan::microseconds(_interval.count()));
+    WaitAsync();
+}
+
+void PeriodicTimer::onTimer(bool canceled)
+{
+    if (canceled)
+    {
+        return;
+    }
+
+    _action();
+    start();
+}
+
+void PeriodicTimer::onError(int error,
+                            const std::string &category,
+                            const std::string &message)
+{
+    Log::error(std::format("periodic timer error occurred with code: "
+                           "error:{},category:{},message:{}",
+                           error,
+                           category,
+                           message),
+               typeid(this).name());
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <server/asio/timer.h>
+
+namespace Play
+{
+
+// Runs an action on the service's I/O threads every interval until canceled.
+class PeriodicTimer : public CppServer::Asio::Timer
+{
+private:
+    std::chrono::microseconds _interval;
+    std::function<void()> _action;
+
+public:
+    PeriodicTimer(const std::shared_ptr<CppServer::Asio::Service> &service,
+                  std::chrono::microseconds interval,
+                  std::function<void()> action);
+
+    void start();
+
+protected:
+    void onTimer(bool canceled) override;
+
+    void onError(int error,
+                 const std::string &category,
+                 const std::string &message) override;
+};
+
+} // namespace Play
@@ -0,0 +1,250 @@
+#include "receive_queue.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace Play;
+
+namespace
+{
+
+inline void cpuRelax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+} // namespace
+
+ReceiveQueue::ReceiveQueue(size_t shards)
+    : _shards(std::make_unique<Shard[]>(std::max<size_t>(shards, 1))),
+      _shardCount(std::max<size_t>(shards, 1))
+{
+#if defined(__linux__)
+    _eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_eventFd < 0)
+    {
+        throw std::runtime_error("eventfd creation failed");
+    }
+#endif
+}
+
+ReceiveQueue::~ReceiveQueue()
+{
+#if defined(__linux__)
+    ::close(_eventFd);
+#endif
+}
+
+void ReceiveQueue::push(std::unique_ptr<ClientMessage> message)
+{
+    push(0, std::move(message));
+}
+
+void ReceiveQueue::push(size_t shard, std::unique_ptr<ClientMessage> message)
+{
+    Shard &target = _shards[shard % _shardCount];
+    target.queue.push(std::move(message));
+    if (target.pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+    {
+        signal();
+    }
+}
+
+std::unique_ptr<ClientMessage> ReceiveQueue::tryPop()
+{
+    std::unique_ptr<ClientMessage> message;
+    popBatch(std::span(&message, 1), 1);
+    return message;
+}
+
+size_t ReceiveQueue::popBatch(
+    std::span<std::unique_ptr<ClientMessage>> messages,
+    size_t max)
+{
+    // reset once for all shards: a shard that fills up after it was visited
+    // signals again
+    resetSignal();
+
+    size_t limit = std::min(max, messages.size());
+    size_t first = _nextShard.fetch_add(1, std::memory_order_relaxed);
+    size_t count = 0;
+    for (size_t i = 0; i < _shardCount && count < limit; i++)
+    {
+        Shard &shard = _shards[(first + i) % _shardCount];
+        count += popShard(shard, messages.subspan(count), limit - count);
+    }
+    return count;
+}
+
+size_t ReceiveQueue::popBatch(
+    size_t shard,
+    std::span<std::unique_ptr<ClientMessage>> messages,
+    size_t max)
+{
+    return popShard(_shards[shard % _shardCount], messages, max);
+}
+
+std::unique_ptr<ClientMessage> ReceiveQueue::waitPop(
+    std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    if (auto message = spin())
+    {
+        return message;
+    }
+
+    while (true)
+    {
+        if (auto message = tryPop())
+        {
+            return message;
+        }
+
+        // a producer that counts its message after this check sees the
+        // 0 -> 1 transition and signals, so the park below cannot miss it
+        if (hasPending())
+        {
+            continue;
+        }
+
+        if (!park(deadline))
+        {
+            return tryPop();
+        }
+    }
+}
+
+int ReceiveQueue::eventFd() const
+{
+#if defined(__linux__)
+    return _eventFd;
+#else
+    return -1;
+#endif
+}
+
+size_t ReceiveQueue::popShard(
+    Shard &shard,
+    std::span<std::unique_ptr<ClientMessage>> messages,
+    size_t max)
+{
+    size_t limit = std::min(max, messages.size());
+    size_t count = 0;
+    while (count < limit && shard.queue.try_pop(messages[count]))
+    {
+        count++;
+    }
+
+    if (count > 0)
+    {
+        shard.pending.fetch_sub(static_cast<int64_t>(count),
+                                std::memory_order_acq_rel);
+    }
+    return count;
+}
+
+bool ReceiveQueue::hasPending() const
+{
+    for (size_t i = 0; i < _shardCount; i++)
+    {
+        if (_shards[i].pending.load(std::memory_order_acquire) > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<ClientMessage> ReceiveQueue::spin()
+{
+    uint32_t limit = _spinLimit.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < limit; i++)
+    {
+        if (hasPending())
+        {
+            if (auto message = tryPop())
+            {
+                // spinning caught the message, allow longer spins next time
+                _spinLimit.store(std::min(limit * 2, MAX_SPIN),
+                                 std::memory_order_relaxed);
+                return message;
+            }
+        }
+        cpuRelax();
+    }
+
+    _spinLimit.store(std::max(limit / 2, MIN_SPIN),
+                     std::memory_order_relaxed);
+    return nullptr;
+}
+
+void ReceiveQueue::signal()
+{
+#if defined(__linux__)
+    uint64_t one = 1;
+    // only fails with EAGAIN when the counter is saturated, which still
+    // leaves the descriptor readable
+    [[maybe_unused]] auto written = ::write(_eventFd, &one, sizeof(one));
+    // set after the write so that whoever clears the flag also drains this
+    // write; a readable descriptor is always followed by a set flag
+    _signaled.store(true, std::memory_order_release);
+#else
+    {
+        std::lock_guard<std::mutex> lock(_parkLock);
+    }
+    _parkCondition.notify_one();
+#endif
+}
+
+void ReceiveQueue::resetSignal()
+{
+    if (!_signaled.exchange(false, std::memory_order_acq_rel))
+    {
+        return;
+    }
+#if defined(__linux__)
+    uint64_t count = 0;
+    [[maybe_unused]] auto read = ::read(_eventFd, &count, sizeof(count));
+#endif
+}
+
+// waits for a signal; false once the deadline has passed
+bool ReceiveQueue::park(std::chrono::steady_clock::time_point deadline)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+    {
+        return false;
+    }
+    auto remaining =
+        std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+
+#if defined(__linux__)
+    pollfd descriptor{_eventFd, POLLIN, 0};
+    int result = ::poll(&descriptor, 1, static_cast<int>(remaining.count()));
+    return result > 0 || (result < 0 && errno == EINTR);
+#else
+    std::unique_lock<std::mutex> lock(_parkLock);
+    return _parkCondition.wait_for(lock, remaining, [this]() {
+        return hasPending();
+    });
+#endif
+}
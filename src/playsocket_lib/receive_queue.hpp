@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <tbb/concurrent_queue.h>
+
+#include "client_message.hpp"
+
+namespace Play
+{
+
+// Inbound message queue shared by the I/O threads (producers) and the logic
+// thread. It is split into shards, normally one per I/O thread, so producers
+// on different threads never touch the same queue or counter; a session
+// always pushes into the same shard, which keeps its messages in order.
+//
+// A consumer can drain all shards in batches, block on them with waitPop(),
+// or watch eventFd() from its own event loop. Producers only signal when a
+// shard goes from empty to non-empty, so a busy consumer costs them nothing.
+class ReceiveQueue
+{
+public:
+    explicit ReceiveQueue(size_t shards = 1);
+    ~ReceiveQueue();
+
+    ReceiveQueue(const ReceiveQueue &) = delete;
+    ReceiveQueue &operator=(const ReceiveQueue &) = delete;
+
+    size_t shardCount() const
+    {
+        return _shardCount;
+    }
+
+    void push(std::unique_ptr<ClientMessage> message);
+    void push(size_t shard, std::unique_ptr<ClientMessage> message);
+
+    // nullptr when every shard is empty
+    std::unique_ptr<ClientMessage> tryPop();
+
+    // moves up to min(max, messages.size()) messages into `messages` and
+    // returns how many were moved; shards are visited round robin
+    size_t popBatch(std::span<std::unique_ptr<ClientMessage>> messages,
+                    size_t max);
+
+    // pops from one shard only, for a consumer per I/O thread. It leaves
+    // the wake-up signal alone, so do not mix it with the calls above.
+    size_t popBatch(size_t shard,
+                    std::span<std::unique_ptr<ClientMessage>> messages,
+                    size_t max);
+
+    // spins briefly, then parks until a message arrives or `timeout`
+    // passes; nullptr on timeout. Meant for a single waiting consumer.
+    std::unique_ptr<ClientMessage> waitPop(std::chrono::milliseconds timeout);
+
+    // readable once messages arrive on an empty shard, for registering with
+    // epoll or an Asio descriptor; tryPop/popBatch reset it before popping,
+    // so drain until they come back empty after it fires. -1 where eventfd
+    // is unavailable.
+    int eventFd() const;
+
+private:
+    struct alignas(64) Shard
+    {
+        tbb::concurrent_queue<std::unique_ptr<ClientMessage>> queue{};
+        // pushes minus pops; it can briefly go negative when a consumer
+        // pops a message before its producer counted it
+        std::atomic<int64_t> pending{0};
+    };
+
+    std::unique_ptr<Shard[]> _shards;
+    size_t _shardCount;
+    // shard the next merged pop starts at
+    std::atomic<size_t> _nextShard{0};
+    std::atomic<bool> _signaled{false};
+    // spin iterations before parking, grown when spinning pays off
+    std::atomic<uint32_t> _spinLimit{MIN_SPIN};
+
+    static constexpr uint32_t MIN_SPIN = 64;
+    static constexpr uint32_t MAX_SPIN = 16 * 1024;
+
+#if defined(__linux__)
+    int _eventFd = -1;
+#else
+    std::mutex _parkLock;
+    std::condition_variable _parkCondition;
+#endif
+
+    size_t popShard(Shard &shard,
+                    std::span<std::unique_ptr<ClientMessage>> messages,
+                    size_t max);
+    bool hasPending() const;
+    void signal();
+    void resetSignal();
+    bool park(std::chrono::steady_clock::time_point deadline);
+    std::unique_ptr<ClientMessage> spin();
+};
+
+} // namespace Play
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstring>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <zmq.hpp>
+
+#include "header_codec.hpp"
+
+namespace Play
+{
+
+// Builds the server-to-client frames handed to RouterSocket: the reply
+// header followed by the body, in one zmq::message_t of exactly the frame's
+// size. It keeps no state, so any thread may encode at any time.
+class ReplyEncoder
+{
+public:
+    // bytes a caller-owned frame reserves in front of the body
+    static constexpr size_t HEADROOM = ReplyHeaderCodec::SIZE;
+
+    // copies the body once, straight after the header
+    static zmq::message_t encode(const ReplyHeader &header,
+                                 std::span<const unsigned char> body)
+    {
+        checkSize(body.size());
+
+        zmq::message_t message(HEADROOM + body.size());
+        auto *frame = static_cast<unsigned char *>(message.data());
+        ReplyHeaderCodec::encode(frame,
+                                 static_cast<uint16_t>(body.size()),
+                                 header);
+        if (!body.empty())
+        {
+            std::memcpy(frame + HEADROOM, body.data(), body.size());
+        }
+        return message;
+    }
+
+    // wraps `frame` without copying, through zmq_msg_init_data. The body
+    // must already sit at frame + HEADROOM; the header is written in front
+    // of it. ZeroMQ calls release(frame, hint) once it is done with the
+    // memory, possibly on one of its own I/O threads.
+    static zmq::message_t wrap(const ReplyHeader &header,
+                               unsigned char *frame,
+                               size_t bodySize,
+                               zmq::free_fn *release,
+                               void *hint = nullptr)
+    {
+        checkSize(bodySize);
+
+        ReplyHeaderCodec::encode(frame,
+                                 static_cast<uint16_t>(bodySize),
+                                 header);
+        return zmq::message_t(frame, HEADROOM + bodySize, release, hint);
+    }
+
+private:
+    static void checkSize(size_t bodySize)
+    {
+        if (bodySize > MAX_PACKET_SIZE)
+        {
+            throw std::out_of_range(std::format(
+                "packet size is over Max - bodysize:{}", bodySize));
+        }
+    }
+};
+
+} // namespace Play
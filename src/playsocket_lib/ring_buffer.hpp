@@ -1,34 +1,72 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 #include <iostream>
 #include <span>
 #include <stdexcept>
 #include <vector>
 
+#include "buffer_pool.hpp"
+
 namespace Play
 {
 
-class RingBuffer
+// Allows any capacity; indices wrap by comparing against the capacity.
+struct ModuloIndex
+{
+    static size_t capacityFor(size_t capacity)
+    {
+        return capacity;
+    }
+
+    // count never exceeds capacity, so a conditional subtraction replaces the
+    // integer division of index % capacity
+    static size_t advance(size_t index, size_t count, size_t capacity)
+    {
+        index += count;
+        return index >= capacity ? index - capacity : index;
+    }
+};
+
+// Rounds the capacity up to a power of two and wraps indices with a mask.
+struct PowerOfTwoIndex
+{
+    static size_t capacityFor(size_t capacity)
+    {
+        return std::bit_ceil(capacity);
+    }
+
+    static size_t advance(size_t index, size_t count, size_t capacity)
+    {
+        return (index + count) & (capacity - 1);
+    }
+};
+
+template <typename IndexPolicy>
+class BasicRingBuffer
 {
 public:
-    explicit RingBuffer(size_t capacity, size_t maxCapacity)
-        : _buffer(capacity), _readerIndex(0), _headerIndex(0), _size(0),
-          _maxCapacity(maxCapacity)
+    explicit BasicRingBuffer(size_t capacity, size_t maxCapacity)
+        : _buffer(IndexPolicy::capacityFor(capacity)), _readerIndex(0),
+          _headerIndex(0), _size(0), _maxCapacity(maxCapacity)
     {
-        if (capacity > maxCapacity)
+        if (this->capacity() > maxCapacity)
         {
             throw std::invalid_argument(
                 "capacity cannot be greater than maxCapacity");
         }
     }
 
-    RingBuffer(size_t capacity) : RingBuffer(capacity, capacity)
+    BasicRingBuffer(size_t capacity) : BasicRingBuffer(capacity, capacity)
     {
     }
 
     size_t capacity() const
     {
-        return _buffer.capacity();
+        return _buffer.size();
     }
 
     size_t size() const
@@ -36,12 +74,15 @@ public:
         return _size;
     }
 
+    // bytes of storage currently held, for memory accounting
+    size_t allocatedBytes() const
+    {
+        return _buffer.size();
+    }
+
     void push(unsigned char item)
     {
-        if (_size == capacity())
-        {
-            resizeBuffer(capacity() * 2);
-        }
+        ensureCapacity(_size + 1);
 
         _buffer[_headerIndex] = item;
         _headerIndex = nextIndex(_headerIndex);
@@ -50,31 +91,27 @@ public:
 
     void push(const std::vector<unsigned char> &data)
     {
-        for (unsigned char b : data)
-        {
-            push(b);
-        }
+        write(data.data(), 0, data.size());
     }
 
     void resizeBuffer(size_t newCapacity)
     {
+        newCapacity = IndexPolicy::capacityFor(newCapacity);
         if (newCapacity > _maxCapacity)
         {
             throw std::out_of_range("Queue has reached maximum capacity");
         }
-
-        std::vector<unsigned char> newBuffer(newCapacity);
-        size_t currentIndex = _readerIndex;
-
-        for (size_t i = 0; i < _size; ++i)
+        if (newCapacity < _size)
         {
-            newBuffer[i] = _buffer[currentIndex];
-            currentIndex = nextIndex(currentIndex);
+            throw std::invalid_argument("capacity cannot be less than size");
         }
 
+        PooledStorage newBuffer(newCapacity);
+        copyOut(_readerIndex, newBuffer.data(), _size);
+
         _buffer = std::move(newBuffer);
         _readerIndex = 0;
-        _headerIndex = _size;
+        _headerIndex = advanceIndex(0, _size);
     }
 
     unsigned char pop()
@@ -111,48 +148,87 @@ public:
         _size = 0;
     }
 
-    void clear(size_t count)
+    // frees the storage of an empty buffer; the next write allocates again
+    void release()
     {
-        if (count > _size)
+        if (_size != 0)
         {
-            throw std::invalid_argument("count exceeds queue size");
+            throw std::logic_error("cannot release a non-empty buffer");
         }
 
-        for (size_t i = 0; i < count; i++)
+        _buffer = PooledStorage();
+        _readerIndex = 0;
+        _headerIndex = 0;
+    }
+
+    void clear(size_t count)
+    {
+        if (count > _size)
         {
-            _readerIndex = nextIndex(_readerIndex);
+            throw std::invalid_argument("count exceeds queue size");
         }
 
+        _readerIndex = advanceIndex(_readerIndex, count);
         _size -= count;
     }
 
     size_t read(unsigned char *buffer, size_t offset, size_t count)
     {
-        size_t bytesRead = 0;
+        size_t bytesRead = std::min(count, _size);
 
-        while (bytesRead < count && _size > 0)
-        {
-            buffer[offset + bytesRead] = pop();
-            bytesRead++;
-        }
+        copyOut(_readerIndex, buffer + offset, bytesRead);
+        clear(bytesRead);
 
         return bytesRead;
     }
 
     void write(const unsigned char *buffer, size_t offset, size_t count)
     {
-        for (size_t i = 0; i < count; i++)
-        {
-            push(buffer[offset + i]);
-        }
+        ensureCapacity(_size + count);
+        copyIn(buffer + offset, count);
     }
 
     void write(const std::span<const unsigned char> &buffer)
     {
-        for (size_t i = 0; i < buffer.size(); i++)
+        write(buffer.data(), 0, buffer.size());
+    }
+
+    // readable bytes in place: the part up to the end of the storage and the
+    // part that wrapped around to the front (empty if nothing wrapped)
+    std::array<std::span<const unsigned char>, 2> readableSpans() const
+    {
+        size_t first = std::min(_size, capacity() - _readerIndex);
+        return {std::span<const unsigned char>(_buffer.data() + _readerIndex,
+                                               first),
+                std::span<const unsigned char>(_buffer.data(), _size - first)};
+    }
+
+    // free space in place, grown first so at least `minimum` bytes fit.
+    // bytes written into the spans become readable after commitWrite().
+    std::array<std::span<unsigned char>, 2> writableSpans(size_t minimum = 0)
+    {
+        ensureCapacity(_size + minimum);
+
+        size_t free = capacity() - _size;
+        size_t first = std::min(free, capacity() - _headerIndex);
+        return {std::span<unsigned char>(_buffer.data() + _headerIndex, first),
+                std::span<unsigned char>(_buffer.data(), free - first)};
+    }
+
+    void commitWrite(size_t count)
+    {
+        if (count > capacity() - _size)
         {
-            push(buffer[i]);
+            throw std::invalid_argument("count exceeds writable space");
         }
+
+        _headerIndex = advanceIndex(_headerIndex, count);
+        _size += count;
+    }
+
+    void consume(size_t count)
+    {
+        clear(count);
     }
 
     int8_t readInt8()
@@ -219,7 +295,7 @@ public:
     }
 
 private:
-    std::vector<unsigned char> _buffer;
+    PooledStorage _buffer;
     size_t _readerIndex;
     size_t _headerIndex;
     size_t _size;
@@ -227,21 +303,70 @@ private:
 
     size_t nextIndex(size_t index) const
     {
-        return (index + 1) % capacity();
+        return advanceIndex(index, 1);
     }
 
-    bool isReadIndexValid(size_t index, size_t size) const
+    size_t advanceIndex(size_t index, size_t count) const
     {
-        size_t tempIndex = index;
-        for (size_t i = 0; i < size; i++)
+        if (capacity() == 0)
+        {
+            return 0;
+        }
+        return IndexPolicy::advance(index, count, capacity());
+    }
+
+    // grows once to the smallest doubling of the current capacity that can
+    // hold `required` bytes, so bulk writes never resize inside a copy loop.
+    void ensureCapacity(size_t required)
+    {
+        if (required <= capacity())
+        {
+            return;
+        }
+
+        size_t newCapacity = std::max<size_t>(capacity(), 1);
+        while (newCapacity < required)
         {
-            if (tempIndex == _headerIndex || _size == 0)
-            {
-                return false;
-            }
-            tempIndex = nextIndex(tempIndex);
+            newCapacity *= 2;
         }
-        return true;
+        resizeBuffer(newCapacity);
+    }
+
+    // copies at most two contiguous segments: [headerIndex, end) and the part
+    // that wraps around to the front of the buffer.
+    void copyIn(const unsigned char *source, size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        size_t first = std::min(count, capacity() - _headerIndex);
+        std::memcpy(_buffer.data() + _headerIndex, source, first);
+        std::memcpy(_buffer.data(), source + first, count - first);
+
+        _headerIndex = advanceIndex(_headerIndex, count);
+        _size += count;
+    }
+
+    void copyOut(size_t index, unsigned char *destination, size_t count) const
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        size_t first = std::min(count, capacity() - index);
+        std::memcpy(destination, _buffer.data() + index, first);
+        std::memcpy(destination + first, _buffer.data(), count - first);
+    }
+
+    bool isReadIndexValid(size_t index, size_t size) const
+    {
+        size_t offset = (index >= _readerIndex)
+                            ? (index - _readerIndex)
+                            : (capacity() - _readerIndex + index);
+        return offset + size <= _size;
     }
 
     int16_t getInt16(size_t index) const
@@ -251,8 +376,10 @@ private:
             throw std::out_of_range("Index out of range");
         }
 
-        return static_cast<int16_t>((_buffer[index] << 8) |
-                                    _buffer[nextIndex(index)]);
+        unsigned char bytes[sizeof(int16_t)];
+        copyOut(index, bytes, sizeof(bytes));
+
+        return static_cast<int16_t>((bytes[0] << 8) | bytes[1]);
     }
 
     int32_t getInt32(size_t index) const
@@ -262,9 +389,10 @@ private:
             throw std::out_of_range("Index out of range");
         }
 
-        return (_buffer[index] << 24) | (_buffer[nextIndex(index)] << 16) |
-               (_buffer[nextIndex(nextIndex(index))] << 8) |
-               _buffer[nextIndex(nextIndex(nextIndex(index)))];
+        unsigned char bytes[sizeof(int32_t)];
+        copyOut(index, bytes, sizeof(bytes));
+
+        return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
     }
 
 
@@ -276,4 +404,8 @@ private:
         return (distance + size) <= capacity();
     }
 };
+
+using RingBuffer = BasicRingBuffer<ModuloIndex>;
+using PowerOfTwoRingBuffer = BasicRingBuffer<PowerOfTwoIndex>;
+
 } // namespace Play
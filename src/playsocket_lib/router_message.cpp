@@ -36,4 +36,37 @@ zmq::message_t &RouterMessage::body()
     return _body;
 }
 
+RouterMessageBatch::RouterMessageBatch(size_t capacity) : _messages(capacity)
+{
+}
+
+size_t RouterMessageBatch::size() const
+{
+    return _size;
+}
+size_t RouterMessageBatch::capacity() const
+{
+    return _messages.size();
+}
+bool RouterMessageBatch::empty() const
+{
+    return _size == 0;
+}
+RouterMessage &RouterMessageBatch::operator[](size_t index)
+{
+    return _messages[index];
+}
+RouterMessage *RouterMessageBatch::begin()
+{
+    return _messages.data();
+}
+RouterMessage *RouterMessageBatch::end()
+{
+    return _messages.data() + _size;
+}
+void RouterMessageBatch::clear()
+{
+    _size = 0;
+}
+
 } // namespace Play
@@ -1,6 +1,7 @@
 
 #pragma once
 #include <iostream>
+#include <vector>
 #include <zmq_addon.hpp>
 
 namespace Play
@@ -13,6 +14,7 @@ private:
     zmq::message_t _body;
 
 public:
+    RouterMessage() = default;
     RouterMessage(const std::string &target,
                   const std::string &Header,
                   zmq::message_t &&body);
@@ -21,10 +23,38 @@ public:
                   zmq::message_t &&body);
     ~RouterMessage();
 
+    RouterMessage(RouterMessage &&other) noexcept = default;
+    RouterMessage &operator=(RouterMessage &&other) noexcept = default;
+
     zmq::message_t &target();
     zmq::message_t &Header();
     zmq::message_t &body();
 };
 
+// Slots RouterSocket::recvBatch() receives into. The slots are allocated
+// once and their frames are received into again on every batch, so a
+// steady stream of messages costs no per-message allocation beyond what
+// ZeroMQ does for large frames. Messages stay valid until the next batch;
+// move one out to keep it longer.
+class RouterMessageBatch
+{
+private:
+    friend class RouterSocket;
+
+    std::vector<RouterMessage> _messages;
+    size_t _size = 0;
+
+public:
+    explicit RouterMessageBatch(size_t capacity = 256);
+
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const;
+    RouterMessage &operator[](size_t index);
+    RouterMessage *begin();
+    RouterMessage *end();
+    // forgets the received messages and keeps the slots
+    void clear();
+};
 
 } // namespace Play
@@ -0,0 +1,216 @@
+#include "router_pump.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using namespace Play;
+
+namespace
+{
+
+#if defined(__linux__)
+int createEventFd()
+{
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+    {
+        throw std::runtime_error("eventfd creation failed");
+    }
+    return fd;
+}
+
+void signalEventFd(int fd)
+{
+    uint64_t one = 1;
+    [[maybe_unused]] auto written = ::write(fd, &one, sizeof(one));
+}
+
+void clearEventFd(int fd)
+{
+    uint64_t count = 0;
+    [[maybe_unused]] auto read = ::read(fd, &count, sizeof(count));
+}
+#endif
+
+} // namespace
+
+RouterPump::RouterPump(RouterSocket &socket, size_t batchSize)
+    : _socket(socket), _batch(batchSize)
+{
+#if defined(__linux__)
+    _wakeFd = createEventFd();
+    _inboxFd = createEventFd();
+#endif
+}
+
+RouterPump::~RouterPump()
+{
+    stop();
+#if defined(__linux__)
+    ::close(_wakeFd);
+    ::close(_inboxFd);
+#endif
+}
+
+void RouterPump::start()
+{
+    if (_running.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    _thread = std::thread([this]() { run(); });
+}
+
+void RouterPump::stop()
+{
+    if (!_running.exchange(false, std::memory_order_acq_rel))
+    {
+        return;
+    }
+#if defined(__linux__)
+    signalEventFd(_wakeFd);
+#endif
+    _thread.join();
+}
+
+void RouterPump::send(RouterMessage &&message)
+{
+    _outbox.push(std::move(message));
+    wake();
+}
+
+bool RouterPump::tryRecv(RouterMessage &message)
+{
+    return recvBatch(std::span(&message, 1), 1) == 1;
+}
+
+size_t RouterPump::recvBatch(std::span<RouterMessage> messages, size_t max)
+{
+    resetInboxSignal();
+
+    size_t limit = std::min(max, messages.size());
+    size_t count = 0;
+    while (count < limit && _inbox.try_pop(messages[count]))
+    {
+        count++;
+    }
+    return count;
+}
+
+int RouterPump::recvEventFd() const
+{
+    return _inboxFd;
+}
+
+void RouterPump::run()
+{
+    zmq::pollitem_t items[] = {
+        {_socket.handle(), 0, ZMQ_POLLIN, 0},
+        {nullptr, _wakeFd, ZMQ_POLLIN, 0},
+    };
+    // without an eventfd, queued sends wait for the next poll timeout
+    size_t itemCount = _wakeFd >= 0 ? 2 : 1;
+    auto timeout = _wakeFd >= 0 ? std::chrono::milliseconds(-1)
+                                : std::chrono::milliseconds(1);
+
+    while (_running.load(std::memory_order_acquire))
+    {
+        try
+        {
+            zmq::poll(items, itemCount, timeout);
+
+#if defined(__linux__)
+            if (items[1].revents & ZMQ_POLLIN)
+            {
+                // cleared before draining: a send queued after the drain
+                // started wakes the pump again
+                clearEventFd(_wakeFd);
+                _wakePending.store(false, std::memory_order_release);
+            }
+#endif
+            drainOutbox();
+
+            if (items[0].revents & ZMQ_POLLIN)
+            {
+                receive();
+            }
+        }
+        catch (zmq::error_t &ex)
+        {
+            Log::error(std::format("router pump error : {}", ex.what()),
+                       typeid(this).name());
+        }
+    }
+
+    drainOutbox();
+}
+
+void RouterPump::drainOutbox()
+{
+    RouterMessage message;
+    while (_outbox.try_pop(message))
+    {
+        try
+        {
+            if (!_socket.send(message))
+            {
+                Log::error("router pump send failed", typeid(this).name());
+            }
+        }
+        catch (zmq::error_t &ex)
+        {
+            // e.g. an unknown target with router_mandatory set
+            Log::error(std::format("router pump send failed : {}", ex.what()),
+                       typeid(this).name());
+        }
+    }
+}
+
+void RouterPump::receive()
+{
+    size_t count = _socket.recvBatch(_batch,
+                                     _batch.capacity(),
+                                     std::chrono::milliseconds(0));
+    if (count == 0)
+    {
+        return;
+    }
+
+    for (RouterMessage &message : _batch)
+    {
+        _inbox.push(std::move(message));
+    }
+    if (!_inboxSignaled.exchange(true, std::memory_order_acq_rel))
+    {
+#if defined(__linux__)
+        signalEventFd(_inboxFd);
+#endif
+    }
+}
+
+void RouterPump::wake()
+{
+    if (!_wakePending.exchange(true, std::memory_order_acq_rel))
+    {
+#if defined(__linux__)
+        signalEventFd(_wakeFd);
+#endif
+    }
+}
+
+void RouterPump::resetInboxSignal()
+{
+    if (_inboxSignaled.exchange(false, std::memory_order_acq_rel))
+    {
+#if defined(__linux__)
+        clearEventFd(_inboxFd);
+#endif
+    }
+}
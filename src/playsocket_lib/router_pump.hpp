@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <span>
+#include <tbb/concurrent_queue.h>
+#include <thread>
+
+#include "logger_interface.hpp"
+#include "router_message.hpp"
+#include "router_socket.hpp"
+
+namespace Play
+{
+
+// Runs a RouterSocket on a thread of its own, so that any number of threads
+// can send and receive through one router identity without locking around
+// the socket, which ZeroMQ does not allow to be shared.
+//
+// send() queues a message on a lock-free queue and wakes the pump thread
+// through an eventfd. The pump thread sends whatever is queued, receives in
+// batches and hands inbound messages to consumers through a second queue.
+// Consumers drain it with tryRecv()/recvBatch(), or watch recvEventFd().
+// Once start() is called, the socket belongs to the pump thread until
+// stop(); do not call it directly in between.
+class RouterPump
+{
+public:
+    explicit RouterPump(RouterSocket &socket, size_t batchSize = 256);
+    ~RouterPump();
+
+    RouterPump(const RouterPump &) = delete;
+    RouterPump &operator=(const RouterPump &) = delete;
+
+    void start();
+    // sends what is still queued, then returns the socket to the caller
+    void stop();
+
+    // any thread; delivery failures are logged by the pump thread
+    void send(RouterMessage &&message);
+
+    // any thread; false when no message is waiting
+    bool tryRecv(RouterMessage &message);
+    // moves up to min(max, messages.size()) messages into `messages` and
+    // returns how many were moved
+    size_t recvBatch(std::span<RouterMessage> messages, size_t max);
+    // readable once messages arrive, for epoll or an Asio descriptor;
+    // tryRecv/recvBatch reset it, so drain until they come back empty after
+    // it fires. -1 where eventfd is unavailable.
+    int recvEventFd() const;
+
+private:
+    RouterSocket &_socket;
+    RouterMessageBatch _batch;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+
+    tbb::concurrent_queue<RouterMessage> _outbox;
+    std::atomic<bool> _wakePending{false};
+    int _wakeFd = -1;
+
+    tbb::concurrent_queue<RouterMessage> _inbox;
+    std::atomic<bool> _inboxSignaled{false};
+    int _inboxFd = -1;
+
+    void run();
+    void drainOutbox();
+    void receive();
+    void wake();
+    void resetInboxSignal();
+};
+
+} // namespace Play
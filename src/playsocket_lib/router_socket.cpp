@@ -1,9 +1,13 @@
 
+#include <algorithm>
+#include <cstring>
 #include <format>
 #include <spdlog/spdlog.h>
 #include <zmq_addon.hpp>
 
 #include "bit_converter.hpp"
+#include "header_codec.hpp"
+#include "reply_encoder.hpp"
 #include "router_message.hpp"
 #include "router_socket.hpp"
 #include "stream_parser.hpp"
@@ -13,8 +17,15 @@ namespace Play
 
 RouterSocket::RouterSocket(const std::string &options,
                            const std::string &endpoint)
+    : RouterSocket(nullptr, options, endpoint)
+{
+}
+RouterSocket::RouterSocket(std::shared_ptr<zmq::context_t> context,
+                           const std::string &options,
+                           const std::string &endpoint)
     : _config(SocketConfig(options)), _endpoint(endpoint),
-      _socket(zmq::socket_t(_ctx, zmq::socket_type::router))
+      _ctx(context != nullptr ? std::move(context) : makeContext(_config)),
+      _socket(zmq::socket_t(*_ctx, zmq::socket_type::router))
 {
 
     _socket.set(zmq::sockopt::routing_id, endpoint);
@@ -31,10 +42,53 @@ RouterSocket::RouterSocket(const std::string &options,
     _socket.set(zmq::sockopt::rcvhwm, _config.receiveHighWatermark());
     _socket.set(zmq::sockopt::sndhwm, _config.sendHighWatermark());
     _socket.set(zmq::sockopt::router_mandatory, _config.routerMandatory());
+    _socket.set(zmq::sockopt::maxmsgsize, _config.maxMessageSize());
+    if (_config.affinity() != 0)
+    {
+        _socket.set(zmq::sockopt::affinity, _config.affinity());
+    }
+    if (_config.tos() != 0)
+    {
+        _socket.set(zmq::sockopt::tos, _config.tos());
+    }
+    if (_config.zeroCopyRecv())
+    {
+#if defined(ZMQ_ZERO_COPY_RECV)
+        int zeroCopy = 1;
+        zmq_setsockopt(_socket.handle(),
+                       ZMQ_ZERO_COPY_RECV,
+                       &zeroCopy,
+                       sizeof(zeroCopy));
+#else
+        Log::warn("zero_copy_recv needs the libzmq draft API, ignored",
+                  typeid(this).name());
+#endif
+    }
 }
 RouterSocket::~RouterSocket()
 {
 }
+std::shared_ptr<zmq::context_t> RouterSocket::makeContext(
+    const SocketConfig &config)
+{
+    auto context = std::make_shared<zmq::context_t>(config.ioThreads());
+    for (int cpu : config.threadAffinityCpus())
+    {
+#if defined(ZMQ_THREAD_AFFINITY_CPU_ADD)
+        int result =
+            zmq_ctx_set(context->handle(), ZMQ_THREAD_AFFINITY_CPU_ADD, cpu);
+        if (result != 0)
+        {
+            Log::warn(std::format("thread affinity cpu {} not set", cpu),
+                      typeid(RouterSocket).name());
+        }
+#else
+        Log::warn(std::format("thread affinity cpu {} needs libzmq 4.3", cpu),
+                  typeid(RouterSocket).name());
+#endif
+    }
+    return context;
+}
 void RouterSocket::bind()
 {
     _socket.bind(_endpoint);
@@ -56,31 +110,79 @@ bool RouterSocket::send(RouterMessage &message)
     return true;
 }
 
-RouterMessage *RouterSocket::recv()
+std::unique_ptr<RouterMessage> RouterSocket::recv()
 {
-    std::vector<zmq::message_t> recv_msgs;
-    const auto ret =
-        zmq::recv_multipart(_socket, std::back_inserter(recv_msgs));
-
-    if (!ret)
+    auto message = std::make_unique<RouterMessage>();
+    if (!_socket.recv(message->target()) || !recvRest(*message))
     {
         return {};
     }
-    if (recv_msgs.size() != 3)
+    return message;
+}
+
+size_t RouterSocket::recvBatch(RouterMessageBatch &batch,
+                               size_t max,
+                               std::chrono::milliseconds timeout)
+{
+    batch.clear();
+
+    zmq::pollitem_t item{_socket.handle(), 0, ZMQ_POLLIN, 0};
+    if (zmq::poll(&item, 1, timeout) <= 0)
     {
-        spdlog::info(
-            std::format("message size is invalid : {}", recv_msgs.size()));
-        return {};
+        return 0;
     }
 
+    size_t limit = std::min(max, batch.capacity());
+    while (batch._size < limit)
+    {
+        RouterMessage &slot = batch[batch._size];
+        if (!_socket.recv(slot.target(), zmq::recv_flags::dontwait))
+        {
+            break;
+        }
+        if (recvRest(slot))
+        {
+            batch._size++;
+        }
+    }
+    return batch._size;
+}
 
-    RouterMessage *message = new RouterMessage(std::move(recv_msgs[0]),
-                                               std::move(recv_msgs[1]),
-                                               std::move(recv_msgs[2]));
+bool RouterSocket::recvRest(RouterMessage &message)
+{
+    // ZeroMQ delivers the parts of a message together, so once the first
+    // one is in the others never block
+    size_t parts = 1;
+    bool more = message.target().more();
+    if (more)
+    {
+        [[maybe_unused]] auto header = _socket.recv(message.Header());
+        parts++;
+        more = message.Header().more();
+    }
+    if (more)
+    {
+        [[maybe_unused]] auto body = _socket.recv(message.body());
+        parts++;
+        more = message.body().more();
+    }
 
-    recv_msgs.clear();
-    return message;
+    zmq::message_t extra;
+    while (more)
+    {
+        [[maybe_unused]] auto part = _socket.recv(extra);
+        parts++;
+        more = extra.more();
+    }
+
+    if (parts != 3)
+    {
+        spdlog::info(std::format("message size is invalid : {}", parts));
+        return false;
+    }
+    return true;
 }
+
 void RouterSocket::connect(const std::string &target)
 {
     _socket.connect(target.c_str());
@@ -89,6 +191,30 @@ void RouterSocket::disconnect(const std::string &target)
 {
     _socket.disconnect(target.c_str());
 }
+void *RouterSocket::handle()
+{
+    return _socket.handle();
+}
+
+namespace
+{
+
+ReplyHeader makeReplyHeader(int16_t serviceId,
+                            int32_t msgId,
+                            int16_t msgSeq,
+                            int16_t errorCode,
+                            int8_t stageIndex)
+{
+    ReplyHeader header;
+    header.service_id = serviceId;
+    header.msg_id = msgId;
+    header.msg_seq = msgSeq;
+    header.error_code = errorCode;
+    header.stage_index = stageIndex;
+    return header;
+}
+
+} // namespace
 
 std::unique_ptr<zmq::message_t> RouterSocket::makeClientMessageBody(
     uint16_t bodySize,
@@ -99,27 +225,28 @@ std::unique_ptr<zmq::message_t> RouterSocket::makeClientMessageBody(
     int8_t stageIndex,
     const unsigned char *body)
 {
+    return std::make_unique<zmq::message_t>(ReplyEncoder::encode(
+        makeReplyHeader(serviceId, msgId, msgSeq, errorCode, stageIndex),
+        std::span<const unsigned char>(body, bodySize)));
+}
 
-    if (bodySize > MAX_PACKET_SIZE)
-    {
-        throw std::out_of_range(
-            std::format("packet size is over Max - bodysize:{}", bodySize));
-    }
-
-    _buffer.clear();
-    _buffer.write(BitConverter::toNetwork(bodySize));
-    _buffer.write(BitConverter::toNetwork(serviceId));
-    _buffer.write(BitConverter::toNetwork(msgId));
-    _buffer.write(BitConverter::toNetwork(msgSeq));
-    _buffer.write(BitConverter::toNetwork(errorCode));
-    _buffer.write(stageIndex);
-    _buffer.write(body, 0, bodySize);
-
-    auto message = std::make_unique<zmq::message_t>(bodySize);
-    _buffer.read(static_cast<unsigned char *>(message->data()),
-                 0,
-                 _buffer.size());
-    return message;
+std::unique_ptr<zmq::message_t> RouterSocket::wrapClientMessageBody(
+    uint16_t bodySize,
+    int16_t serviceId,
+    int32_t msgId,
+    int16_t msgSeq,
+    int16_t errorCode,
+    int8_t stageIndex,
+    unsigned char *frame,
+    zmq::free_fn *release,
+    void *hint)
+{
+    return std::make_unique<zmq::message_t>(ReplyEncoder::wrap(
+        makeReplyHeader(serviceId, msgId, msgSeq, errorCode, stageIndex),
+        frame,
+        bodySize,
+        release,
+        hint));
 }
 
 } // namespace Play
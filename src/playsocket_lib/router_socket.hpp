@@ -1,12 +1,13 @@
 #pragma once
+#include <chrono>
 #include <cxxopts.hpp>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 #include <zmq.hpp>
 
 #include "logger_interface.hpp"
-#include "ring_buffer.hpp"
 #include "router_message.hpp"
 
 namespace Play
@@ -51,7 +52,22 @@ public:
                                        cxxopts::value<int>())(
                 "receive_high_watermark",
                 "Receive high watermark option",
-                cxxopts::value<int>());
+                cxxopts::value<int>())("io_threads",
+                                       "Context I/O threads option",
+                                       cxxopts::value<int>())(
+                "thread_affinity_cpu",
+                "Context I/O thread CPU option, repeatable",
+                cxxopts::value<std::vector<int>>())(
+                "affinity",
+                "Socket I/O thread affinity bitmask option",
+                cxxopts::value<uint64_t>())("max_message_size",
+                                            "Max message size option",
+                                            cxxopts::value<int64_t>())(
+                "zero_copy_recv",
+                "Zero copy receive option",
+                cxxopts::value<bool>())("tos",
+                                        "IP type of service option",
+                                        cxxopts::value<int>());
 
             std::vector<std::string> optionTokens;
             std::istringstream iss(option);
@@ -71,18 +87,24 @@ public:
             auto result = options.parse(fake_argv.size(), fake_argv.data());
 
             // 파싱된 값을 멤버 변수에 설정
-            _immediate = result["immediate"].as<bool>();
-            _routerHandOver = result["router_handover"].as<bool>();
-            _routerMandatory = result["router_mandatory"].as<bool>();
-            _tcpKeepAlive = result["tcp_keepalive"].as<int>();
-            _tcpKeepAliveCount = result["tcp_keepalive_count"].as<int>();
-            _tcpKeepAliveInterval = result["tcp_keepalive_interval"].as<int>();
-            _backLog = result["backlog"].as<int>();
-            _linger = result["linger"].as<int>();
-            _sendBufferSize = result["send_buffer_size"].as<int>();
-            _receiveBufferSize = result["receive_buffer_size"].as<int>();
-            _sendHighWatermark = result["send_high_watermark"].as<int>();
-            _receiveHighWatermark = result["receive_high_watermark"].as<int>();
+            read(result, "immediate", _immediate);
+            read(result, "router_handover", _routerHandOver);
+            read(result, "router_mandatory", _routerMandatory);
+            read(result, "tcp_keepalive", _tcpKeepAlive);
+            read(result, "tcp_keepalive_count", _tcpKeepAliveCount);
+            read(result, "tcp_keepalive_interval", _tcpKeepAliveInterval);
+            read(result, "backlog", _backLog);
+            read(result, "linger", _linger);
+            read(result, "send_buffer_size", _sendBufferSize);
+            read(result, "receive_buffer_size", _receiveBufferSize);
+            read(result, "send_high_watermark", _sendHighWatermark);
+            read(result, "receive_high_watermark", _receiveHighWatermark);
+            read(result, "io_threads", _ioThreads);
+            read(result, "thread_affinity_cpu", _threadAffinityCpus);
+            read(result, "affinity", _affinity);
+            read(result, "max_message_size", _maxMessageSize);
+            read(result, "zero_copy_recv", _zeroCopyRecv);
+            read(result, "tos", _tos);
         }
         catch (std::exception ex)
         {
@@ -158,6 +180,37 @@ public:
         return _receiveHighWatermark;
     }
 
+    // context options, used only when the socket creates its own context
+    int32_t ioThreads() const
+    {
+        return _ioThreads;
+    }
+
+    const std::vector<int> &threadAffinityCpus() const
+    {
+        return _threadAffinityCpus;
+    }
+
+    uint64_t affinity() const
+    {
+        return _affinity;
+    }
+
+    int64_t maxMessageSize() const
+    {
+        return _maxMessageSize;
+    }
+
+    bool zeroCopyRecv() const
+    {
+        return _zeroCopyRecv;
+    }
+
+    int32_t tos() const
+    {
+        return _tos;
+    }
+
     std::string toString() const
     {
         return std::format("SocketConfig:\n"
@@ -172,7 +225,13 @@ public:
                            "  sendBufferSize: {}\n"
                            "  receiveBufferSize: {}\n"
                            "  sendHighWatermark: {}\n"
-                           "  receiveHighWatermark: {}",
+                           "  receiveHighWatermark: {}\n"
+                           "  ioThreads: {}\n"
+                           "  threadAffinityCpus: {}\n"
+                           "  affinity: {}\n"
+                           "  maxMessageSize: {}\n"
+                           "  zeroCopyRecv: {}\n"
+                           "  tos: {}",
                            _immediate,
                            _routerHandOver,
                            _routerMandatory,
@@ -184,7 +243,13 @@ public:
                            _sendBufferSize,
                            _receiveBufferSize,
                            _sendHighWatermark,
-                           _receiveHighWatermark);
+                           _receiveHighWatermark,
+                           _ioThreads,
+                           _threadAffinityCpus.size(),
+                           _affinity,
+                           _maxMessageSize,
+                           _zeroCopyRecv,
+                           _tos);
     }
 
 private:
@@ -200,29 +265,75 @@ private:
     int32_t _receiveBufferSize = 1024 * 1024;
     int32_t _sendHighWatermark = 1000000;
     int32_t _receiveHighWatermark = 1000000;
+    int32_t _ioThreads = 1;
+    std::vector<int> _threadAffinityCpus;
+    // zero leaves the choice of I/O thread to ZeroMQ
+    uint64_t _affinity = 0;
+    // -1 for no limit
+    int64_t _maxMessageSize = -1;
+    // needs the libzmq draft API
+    bool _zeroCopyRecv = false;
+    int32_t _tos = 0;
+
+    // options left out keep their defaults
+    template <typename T>
+    static void read(const cxxopts::ParseResult &result,
+                     const std::string &name,
+                     T &value)
+    {
+        if (result.count(name) > 0)
+        {
+            value = result[name].as<T>();
+        }
+    }
 };
 
 
 class RouterSocket
 {
 private:
-    zmq::context_t _ctx{};
-    zmq::socket_t _socket;
-    const std::string _endpoint;
     const SocketConfig _config;
-    RingBuffer _buffer{64 * 1024, 64 * 1024 * 2};
+    const std::string _endpoint;
+    std::shared_ptr<zmq::context_t> _ctx;
+    zmq::socket_t _socket;
+
+    // receives the parts of a message after its first into `message`;
+    // false, with the rest of the message discarded, unless it had exactly
+    // three parts
+    bool recvRest(RouterMessage &message);
 
 public:
+    // creates a context of its own from the context options
     RouterSocket(const std::string &options, const std::string &address);
+    // shares `context` with other sockets; the context options are ignored
+    RouterSocket(std::shared_ptr<zmq::context_t> context,
+                 const std::string &options,
+                 const std::string &address);
     ~RouterSocket();
 
+    // a context with `config`'s I/O threads and CPU affinity, to share
+    // between sockets
+    static std::shared_ptr<zmq::context_t> makeContext(
+        const SocketConfig &config);
+
     void bind();
     bool send(Play::RouterMessage &message);
-    Play::RouterMessage *recv();
+    // blocks until a message arrives; nullptr for a malformed one
+    std::unique_ptr<Play::RouterMessage> recv();
+    // waits up to `timeout` for messages with one poll, then drains up to
+    // min(max, batch.capacity()) of them without blocking. Malformed
+    // messages are skipped. Returns the number received into `batch`.
+    size_t recvBatch(RouterMessageBatch &batch,
+                     size_t max,
+                     std::chrono::milliseconds timeout);
     void connect(const std::string &target);
     void disconnect(const std::string &target);
+    // the native socket, for zmq::poll alongside other items; only the
+    // thread that uses this socket may poll it
+    void *handle();
 
-    std::unique_ptr<zmq::message_t> makeClientMessageBody(
+    // encodes a reply frame with one copy of the body; see ReplyEncoder
+    static std::unique_ptr<zmq::message_t> makeClientMessageBody(
         uint16_t bodySize,
         int16_t serviceId,
         int32_t msgId,
@@ -230,5 +341,18 @@ public:
         int16_t errorCode,
         int8_t stageIndex,
         const unsigned char *body);
+    // zero-copy variant: `frame` is caller-owned, with the body after
+    // ReplyEncoder::HEADROOM spare bytes, and goes to release(frame, hint)
+    // once ZeroMQ has sent it
+    static std::unique_ptr<zmq::message_t> wrapClientMessageBody(
+        uint16_t bodySize,
+        int16_t serviceId,
+        int32_t msgId,
+        int16_t msgSeq,
+        int16_t errorCode,
+        int8_t stageIndex,
+        unsigned char *frame,
+        zmq::free_fn *release,
+        void *hint = nullptr);
 };
 } // namespace Play
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace Play
+{
+
+// When a session's outbound frames are gathered into one write.
+struct SendCoalescingPolicy
+{
+    // off keeps one SendAsync per message
+    bool enabled = false;
+    // a session writes as soon as this many bytes are staged
+    size_t flushBytes = 16 * 1024;
+    // how long staged frames may wait for flushSends() before the socket
+    // flushes them itself, zero leaves it to flushSends()
+    std::chrono::microseconds flushDelay{0};
+};
+
+// Process-wide counters of coalesced writes, for tuning the policy.
+// frames() / flushes() is the mean number of frames per write, and
+// flushesWithFrames(b) counts writes of [2^b, 2^(b+1)) frames, the last
+// bucket taking everything larger.
+class SendCoalescingStats
+{
+public:
+    static constexpr size_t BUCKETS = 8;
+
+    static int64_t flushes()
+    {
+        return _flushes.load(std::memory_order_relaxed);
+    }
+
+    static int64_t frames()
+    {
+        return _frames.load(std::memory_order_relaxed);
+    }
+
+    static int64_t bytes()
+    {
+        return _bytes.load(std::memory_order_relaxed);
+    }
+
+    static int64_t flushesWithFrames(size_t bucket)
+    {
+        return _buckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    static void record(size_t frames, size_t bytes)
+    {
+        _flushes.fetch_add(1, std::memory_order_relaxed);
+        _frames.fetch_add(static_cast<int64_t>(frames),
+                          std::memory_order_relaxed);
+        _bytes.fetch_add(static_cast<int64_t>(bytes),
+                         std::memory_order_relaxed);
+
+        size_t bucket = std::bit_width(frames) - 1;
+        _buckets[bucket < BUCKETS ? bucket : BUCKETS - 1].fetch_add(
+            1,
+            std::memory_order_relaxed);
+    }
+
+private:
+    inline static std::atomic<int64_t> _flushes{0};
+    inline static std::atomic<int64_t> _frames{0};
+    inline static std::atomic<int64_t> _bytes{0};
+    inline static std::array<std::atomic<int64_t>, BUCKETS> _buckets{};
+};
+
+// Outbound staging buffer of one session. Frames may be appended from any
+// thread. A flush hands the staged bytes to the writer while still holding
+// the lock, so writes reach the session in the order they were staged.
+class SendCoalescer
+{
+private:
+    std::mutex _lock;
+    std::vector<unsigned char> _staged;
+    size_t _frames = 0;
+    // a flush has been requested since the last one ran
+    bool _scheduled = false;
+
+public:
+    // stages `prefix` followed by `frame` and writes everything once
+    // `flushBytes` are staged. Returns true when the caller should arrange
+    // a later flush() for frames that are left staged.
+    template <typename Write>
+    bool append(std::span<const unsigned char> prefix,
+                std::span<const unsigned char> frame,
+                size_t flushBytes,
+                Write &&write)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        _staged.insert(_staged.end(), prefix.begin(), prefix.end());
+        _staged.insert(_staged.end(), frame.begin(), frame.end());
+        _frames++;
+
+        if (_staged.size() >= flushBytes)
+        {
+            writeStaged(write);
+            return false;
+        }
+        if (_scheduled)
+        {
+            return false;
+        }
+        _scheduled = true;
+        return true;
+    }
+
+    // writes whatever is staged, returns the number of frames written
+    template <typename Write>
+    size_t flush(Write &&write)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _scheduled = false;
+        return writeStaged(write);
+    }
+
+    size_t stagedBytes()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _staged.size();
+    }
+
+private:
+    template <typename Write>
+    size_t writeStaged(Write &write)
+    {
+        size_t frames = _frames;
+        if (frames == 0)
+        {
+            return 0;
+        }
+
+        write(std::span<const unsigned char>(_staged));
+        SendCoalescingStats::record(frames, _staged.size());
+        _staged.clear();
+        _frames = 0;
+        return frames;
+    }
+};
+
+} // namespace Play
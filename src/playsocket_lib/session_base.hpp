@@ -0,0 +1,267 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <memory>
+#include <span>
+
+#include "client_message.hpp"
+#include "idle_monitor.hpp"
+#include "io_service.hpp"
+#include "logger_interface.hpp"
+#include "outbound_queue.hpp"
+#include "send_coalescer.hpp"
+#include "shared_payload.hpp"
+#include "stream_parser.hpp"
+
+namespace Play
+{
+
+// What Session and WSSession share on top of their CppServer `Transport`:
+// registration with the owning `Socket`, parsing into its receive queues,
+// the outbound path with backpressure, coalescing and pending stats, and
+// idle tracking. The derived session forwards its CppServer callbacks to
+// opened(), closed() and received(), and provides
+// wire(const SharedPayload &), the bytes a payload goes out as.
+//
+// Frames are written as an optional header, like a WebSocket frame header,
+// followed by the frame. Every write without coalescing happens under the
+// OutboundQueue lock, so the two parts reach the connection together.
+template <typename Derived, typename Transport, typename Socket>
+class SessionBase : public Transport
+{
+public:
+    template <typename Server>
+    SessionBase(std::shared_ptr<Socket> socket,
+                const std::shared_ptr<Server> &server)
+        : Transport(server), _socket(std::move(socket))
+    {
+    }
+
+    // reclaims the parser buffer on the session's own I/O thread
+    void reclaimBuffer(std::chrono::steady_clock::time_point now)
+    {
+        auto self =
+            std::dynamic_pointer_cast<Derived>(this->shared_from_this());
+        dispatch([self, now]() {
+            if (self->_parser != nullptr)
+            {
+                self->_parser->reclaim(now);
+            }
+        });
+    }
+
+    // queues one outbound payload under the socket's backpressure policy
+    SendStatus send(const SharedPayload &payload, SendClass sendClass)
+    {
+        return submit({},
+                      derived().wire(payload),
+                      sendClass,
+                      [&payload]() { return payload; });
+    }
+
+    void flushStaged()
+    {
+        _outbound.flush(
+            [this](std::span<const unsigned char> data) { transmit(data); });
+    }
+
+    SessionActivity &activity()
+    {
+        return _activity;
+    }
+
+protected:
+    int64_t _sid = 0;
+    // receive shard of the I/O thread the session runs on
+    size_t _shard = 0;
+    std::shared_ptr<Socket> _socket;
+
+    void opened()
+    {
+        _sid = _socket->addSession(
+            std::dynamic_pointer_cast<Derived>(this->shared_from_this()));
+        _socket->_idle.track(_sid, _activity);
+        _shard = static_cast<size_t>(std::max(IoService::currentThread(), 0));
+        _parser =
+            std::make_unique<StreamParser>(_sid, _socket->_reclaimPolicy);
+
+        Log::debug(std::format("session connected : {}", _sid),
+                   typeid(this).name());
+        _socket->deliver(
+            _shard,
+            std::make_unique<ClientMessage>(_sid, MessageType::CONNECT));
+    }
+
+    void closed()
+    {
+        Log::debug(std::format("session disconnected : {}", _sid),
+                   typeid(this).name());
+
+        _socket->deliver(
+            _shard,
+            std::make_unique<ClientMessage>(_sid, MessageType::DISCONNECT));
+
+        _socket->removeSession(_sid);
+        // sends that already found the session may still reach it, but its
+        // parser buffer and outbound backlog are not needed any more
+        _parser.reset();
+        _backlog.clear();
+        reportPending(0);
+    }
+
+    void received(const void *buffer, size_t size)
+    {
+        markReceived();
+
+        try
+        {
+            _parser->parse(static_cast<const unsigned char *>(buffer),
+                           0,
+                           size,
+                           [this](std::unique_ptr<ClientMessage> message) {
+                               _socket->deliver(_shard, std::move(message));
+                           });
+        }
+        catch (std::exception &)
+        {
+            Log::error(std::format("message exception occurred: {}", _sid),
+                       typeid(this).name());
+            this->Disconnect();
+        }
+    }
+
+    void markReceived()
+    {
+        _activity.received.store(_socket->_idle.now(),
+                                 std::memory_order_relaxed);
+    }
+
+    // `header` goes out right before `frame` and may be empty; payload()
+    // returns a SharedPayload of both, only called when the frame is held
+    // back
+    template <typename Payload>
+    SendStatus submit(std::span<const unsigned char> header,
+                      std::span<const unsigned char> frame,
+                      SendClass sendClass,
+                      Payload &&payload)
+    {
+        size_t pending = this->bytes_pending() + _outbound.stagedBytes();
+        // what release wrote is pending now too
+        pending += releaseHeld(pending);
+
+        SendStatus status = _backlog.submit(
+            header.size() + frame.size(),
+            sendClass,
+            pending,
+            _socket->_backpressurePolicy,
+            [this, header, frame]() { write(header, frame); },
+            payload);
+        if (status == SendStatus::Disconnected)
+        {
+            Log::info(std::format("slow session disconnected : {}", _sid),
+                      typeid(this).name());
+            this->Disconnect();
+        }
+        return status;
+    }
+
+    void onSent(size_t sent, size_t pending) override
+    {
+        reportPending(pending);
+        releaseHeld(pending + _outbound.stagedBytes());
+    }
+
+    void dispatch(std::function<void()> handler)
+    {
+        if (this->server()->service()->IsStrandRequired())
+        {
+            this->strand().dispatch(std::move(handler));
+        }
+        else
+        {
+            this->io_service()->dispatch(std::move(handler));
+        }
+    }
+
+private:
+    std::unique_ptr<StreamParser> _parser;
+    SendCoalescer _outbound;
+    OutboundQueue _backlog;
+    // bytes_pending() as last added to OutboundStats
+    std::atomic<size_t> _reportedPending{0};
+    SessionActivity _activity;
+
+    Derived &derived()
+    {
+        return static_cast<Derived &>(*this);
+    }
+
+    size_t releaseHeld(size_t pending)
+    {
+        bool flushed = false;
+        return _backlog.release(
+            pending,
+            _socket->_backpressurePolicy,
+            [this, &flushed](const SharedPayload &payload) {
+                // staged frames are older than the held ones
+                if (!flushed)
+                {
+                    flushStaged();
+                    flushed = true;
+                }
+                transmit(derived().wire(payload));
+            });
+    }
+
+    void write(std::span<const unsigned char> header,
+               std::span<const unsigned char> frame)
+    {
+        if (_socket->_sendPolicy.enabled)
+        {
+            stage(header, frame);
+            return;
+        }
+        if (!header.empty())
+        {
+            this->SendAsync(header.data(), header.size());
+        }
+        transmit(frame);
+    }
+
+    // stages a frame for a coalesced write, see SendCoalescingPolicy
+    void stage(std::span<const unsigned char> header,
+               std::span<const unsigned char> frame)
+    {
+        bool schedule = _outbound.append(
+            header,
+            frame,
+            _socket->_sendPolicy.flushBytes,
+            [this](std::span<const unsigned char> data) { transmit(data); });
+        if (schedule)
+        {
+            _socket->_stagedSessions.push(_sid);
+        }
+    }
+
+    void transmit(std::span<const unsigned char> data)
+    {
+        // every write stamps the session, so busy sessions are not sent
+        // heartbeats
+        _activity.sent.store(_socket->_idle.now(), std::memory_order_relaxed);
+        this->SendAsync(data.data(), data.size());
+        reportPending(this->bytes_pending());
+    }
+
+    void reportPending(size_t pending)
+    {
+        size_t reported = _reportedPending.exchange(pending);
+        OutboundStats::addQueued(static_cast<int64_t>(pending) -
+                                 static_cast<int64_t>(reported));
+    }
+};
+
+} // namespace Play
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Play
+{
+
+// Generational slot map from session ids to sessions. A sid packs a 31-bit
+// generation above a 32-bit slot index, so it stays positive and a slot that
+// is reused for a later connection hands out a different sid: a stale sid
+// finds nothing instead of another session.
+//
+// Slots live in segments that never move, so find() takes no lock and no
+// reference: it loads the slot's current sid and session pointer and
+// re-checks the sid, the way a seqlock reader does. Inserts and removals
+// take a mutex.
+//
+// Removed sessions are reclaimed by epochs. A lookup runs under a
+// ReadGuard from pin(), which counts the reader in the current epoch. The
+// registry keeps its reference to a removed session until the epoch has
+// advanced twice, and it only advances once nobody is reading in the
+// previous one, so a pointer found under a guard stays valid until the
+// guard ends. Freed slots are still reused FIFO to spread generations over
+// the slots.
+template <typename T>
+class SessionRegistry
+{
+public:
+    static constexpr uint32_t SEGMENT_SLOTS = 1024;
+    static constexpr uint32_t MAX_SEGMENTS = 4096;
+    static constexpr size_t READER_STRIPES = 16;
+
+    // keeps every session found under it alive until it is destroyed;
+    // guards are cheap, take one per send or per batch of lookups
+    class ReadGuard
+    {
+    public:
+        ReadGuard(ReadGuard &&other) noexcept
+            : _readers(std::exchange(other._readers, nullptr))
+        {
+        }
+
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+        ReadGuard &operator=(ReadGuard &&) = delete;
+
+        ~ReadGuard()
+        {
+            if (_readers != nullptr)
+            {
+                _readers->fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+    private:
+        friend class SessionRegistry;
+
+        explicit ReadGuard(std::atomic<int64_t> *readers) : _readers(readers)
+        {
+        }
+
+        std::atomic<int64_t> *_readers;
+    };
+
+    SessionRegistry() = default;
+
+    SessionRegistry(const SessionRegistry &) = delete;
+    SessionRegistry &operator=(const SessionRegistry &) = delete;
+
+    ~SessionRegistry()
+    {
+        for (auto &segment : _segments)
+        {
+            delete[] segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    // registers `value` and returns its new sid
+    int64_t insert(std::shared_ptr<T> value)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+
+        uint32_t index = acquireSlot();
+        Slot &slot = slotAt(index);
+
+        slot.generation = nextGeneration(slot.generation);
+        int64_t sid = makeSid(slot.generation, index);
+
+        slot.value.store(value.get(), std::memory_order_release);
+        slot.owner = std::move(value);
+        slot.sid.store(sid, std::memory_order_release);
+        _size++;
+        return sid;
+    }
+
+    // unregisters the session, returning false for an unknown or stale sid
+    bool remove(int64_t sid)
+    {
+        // released after the lock, session destructors may call back
+        std::vector<std::shared_ptr<T>> reclaimed;
+        std::lock_guard<std::mutex> lock(_lock);
+
+        Slot *slot = slotFor(sid);
+        if (slot == nullptr ||
+            slot->sid.load(std::memory_order_relaxed) != sid)
+        {
+            return false;
+        }
+
+        vacate(*slot);
+        _free.push_back(slotIndex(sid));
+        _size--;
+        advance(reclaimed);
+        return true;
+    }
+
+    // unregisters every session; those in use under a guard are released
+    // once it ends, sids stay unique
+    void clear()
+    {
+        std::vector<std::shared_ptr<T>> reclaimed;
+        std::lock_guard<std::mutex> lock(_lock);
+
+        _free.clear();
+        for (uint32_t index = 0; index < _nextSlot; index++)
+        {
+            Slot &slot = slotAt(index);
+            if (slot.sid.load(std::memory_order_relaxed) != 0)
+            {
+                vacate(slot);
+            }
+            _free.push_back(index);
+        }
+        _size = 0;
+        advance(reclaimed);
+    }
+
+    // enters the current epoch for a run of find() calls
+    ReadGuard pin() const
+    {
+        size_t stripe = readerStripe();
+        while (true)
+        {
+            uint64_t epoch = _epoch.load(std::memory_order_seq_cst);
+            std::atomic<int64_t> &readers =
+                _readers[epoch & 1][stripe].count;
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            // the epoch moved on before the reader was counted; the
+            // registry may already have reclaimed what that epoch covered
+            if (_epoch.load(std::memory_order_seq_cst) == epoch)
+            {
+                return ReadGuard(&readers);
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    // the session registered under `sid`, or nullptr if there is none; the
+    // pointer is valid while the guard lives
+    T *find(int64_t sid, const ReadGuard &) const
+    {
+        const Slot *slot = slotFor(sid);
+        if (slot == nullptr ||
+            slot->sid.load(std::memory_order_acquire) != sid)
+        {
+            return nullptr;
+        }
+
+        T *value = slot->value.load(std::memory_order_acquire);
+        // the slot may have been removed and reused in between; a sid is
+        // never handed out twice, so an unchanged sid means the value still
+        // belongs to it
+        if (slot->sid.load(std::memory_order_acquire) != sid)
+        {
+            return nullptr;
+        }
+        return value;
+    }
+
+    // calls fn(sid, T&) for every registered session, without blocking
+    // inserts or removals; sessions added or removed meanwhile may be missed
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        ReadGuard guard = pin();
+        uint32_t segments = _segmentCount.load(std::memory_order_acquire);
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            const Slot *slots = _segments[s].load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < SEGMENT_SLOTS; i++)
+            {
+                int64_t sid = slots[i].sid.load(std::memory_order_acquire);
+                if (sid == 0)
+                {
+                    continue;
+                }
+                if (T *value = find(sid, guard))
+                {
+                    fn(sid, *value);
+                }
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _size;
+    }
+
+    // removed sessions the registry still holds for guarded readers
+    size_t retired() const
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return _retired[0].size() + _retired[1].size();
+    }
+
+private:
+    struct Slot
+    {
+        // sid of the registered session, 0 while the slot is free
+        std::atomic<int64_t> sid{0};
+        // read by find() without the lock
+        std::atomic<T *> value{nullptr};
+        // only touched under _lock
+        std::shared_ptr<T> owner;
+        uint32_t generation = 0;
+    };
+
+    struct alignas(64) ReaderCount
+    {
+        std::atomic<int64_t> count{0};
+    };
+
+    std::array<std::atomic<Slot *>, MAX_SEGMENTS> _segments{};
+    std::atomic<uint32_t> _segmentCount{0};
+    uint32_t _nextSlot = 0;
+    std::deque<uint32_t> _free;
+    size_t _size = 0;
+    mutable std::mutex _lock;
+
+    // readers counted by the parity of the epoch they entered, spread over
+    // stripes so threads do not share one counter
+    std::atomic<uint64_t> _epoch{0};
+    mutable std::array<std::array<ReaderCount, READER_STRIPES>, 2> _readers{};
+    // removed sessions by the parity of the epoch they were removed in
+    std::array<std::vector<std::shared_ptr<T>>, 2> _retired;
+
+    static int64_t makeSid(uint32_t generation, uint32_t index)
+    {
+        return static_cast<int64_t>(generation) << 32 | index;
+    }
+
+    static uint32_t slotIndex(int64_t sid)
+    {
+        return static_cast<uint32_t>(sid);
+    }
+
+    static uint32_t nextGeneration(uint32_t generation)
+    {
+        generation = (generation + 1) & 0x7FFFFFFF;
+        return generation == 0 ? 1 : generation;
+    }
+
+    static size_t readerStripe()
+    {
+        static thread_local size_t stripe =
+            std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+            READER_STRIPES;
+        return stripe;
+    }
+
+    Slot &slotAt(uint32_t index) const
+    {
+        Slot *slots =
+            _segments[index / SEGMENT_SLOTS].load(std::memory_order_acquire);
+        return slots[index % SEGMENT_SLOTS];
+    }
+
+    const Slot *slotFor(int64_t sid) const
+    {
+        if (sid <= 0)
+        {
+            return nullptr;
+        }
+
+        uint32_t index = slotIndex(sid);
+        if (index / SEGMENT_SLOTS >=
+            _segmentCount.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &slotAt(index);
+    }
+
+    Slot *slotFor(int64_t sid)
+    {
+        return const_cast<Slot *>(std::as_const(*this).slotFor(sid));
+    }
+
+    // unpublishes the slot's session and retires the registry's reference
+    // in the current epoch
+    void vacate(Slot &slot)
+    {
+        slot.sid.store(0, std::memory_order_release);
+        slot.value.store(nullptr, std::memory_order_release);
+        uint64_t epoch = _epoch.load(std::memory_order_relaxed);
+        _retired[epoch & 1].push_back(std::move(slot.owner));
+    }
+
+    // moves the epoch on while nobody reads in the previous one, at most
+    // twice, handing what became unreachable to `reclaimed`
+    void advance(std::vector<std::shared_ptr<T>> &reclaimed)
+    {
+        for (int step = 0; step < 2; step++)
+        {
+            uint64_t epoch = _epoch.load(std::memory_order_relaxed);
+            // the previous epoch shares its parity with the next one
+            auto &previous = _readers[(epoch + 1) & 1];
+            for (const ReaderCount &readers : previous)
+            {
+                if (readers.count.load(std::memory_order_seq_cst) != 0)
+                {
+                    return;
+                }
+            }
+            _epoch.store(epoch + 1, std::memory_order_seq_cst);
+
+            // removed before the epoch that just ended began, so every
+            // reader that could have found them is gone
+            auto &unreachable = _retired[(epoch + 1) & 1];
+            for (auto &session : unreachable)
+            {
+                reclaimed.push_back(std::move(session));
+            }
+            unreachable.clear();
+        }
+    }
+
+    uint32_t acquireSlot()
+    {
+        if (!_free.empty())
+        {
+            uint32_t index = _free.front();
+            _free.pop_front();
+            return index;
+        }
+
+        uint32_t index = _nextSlot;
+        uint32_t segment = index / SEGMENT_SLOTS;
+        if (segment == _segmentCount.load(std::memory_order_relaxed))
+        {
+            if (segment == MAX_SEGMENTS)
+            {
+                throw std::length_error("session registry is full");
+            }
+            _segments[segment].store(new Slot[SEGMENT_SLOTS],
+                                     std::memory_order_release);
+            _segmentCount.store(segment + 1, std::memory_order_release);
+        }
+        _nextSlot++;
+        return index;
+    }
+};
+
+} // namespace Play
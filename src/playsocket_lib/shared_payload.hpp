@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <span>
+
+#include "ws_frame.hpp"
+
+namespace Play
+{
+
+// Immutable, reference-counted outbound payload for sending the same bytes
+// to many sessions. It is copied once on construction, and the WebSocket
+// binary frame header is written right in front of it, so wsFrame() is a
+// ready-to-send frame shared by every WebSocket session.
+class SharedPayload
+{
+private:
+    std::shared_ptr<unsigned char[]> _storage;
+    // where the frame header starts; the payload starts at MAX_SIZE
+    size_t _frameOffset = WSFrameHeader::MAX_SIZE;
+    size_t _size = 0;
+
+public:
+    SharedPayload() = default;
+
+    explicit SharedPayload(std::span<const unsigned char> payload)
+        : _storage(std::make_shared_for_overwrite<unsigned char[]>(
+              WSFrameHeader::MAX_SIZE + payload.size())),
+          _size(payload.size())
+    {
+        if (!payload.empty())
+        {
+            std::memcpy(&_storage[WSFrameHeader::MAX_SIZE],
+                        payload.data(),
+                        payload.size());
+        }
+
+        WSFrameHeader header = WSFrameHeader::binary(payload.size());
+        auto headerBytes = header.bytes();
+        _frameOffset = WSFrameHeader::MAX_SIZE - headerBytes.size();
+        std::memcpy(&_storage[_frameOffset],
+                    headerBytes.data(),
+                    headerBytes.size());
+    }
+
+    // the payload as given
+    std::span<const unsigned char> bytes() const
+    {
+        return {_storage.get() + WSFrameHeader::MAX_SIZE, _size};
+    }
+
+    // the payload framed as one binary WebSocket message
+    std::span<const unsigned char> wsFrame() const
+    {
+        return {_storage.get() + _frameOffset,
+                WSFrameHeader::MAX_SIZE - _frameOffset + _size};
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    long useCount() const
+    {
+        return _storage.use_count();
+    }
+};
+
+} // namespace Play
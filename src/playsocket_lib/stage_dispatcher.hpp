@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "client_message.hpp"
+#include "receive_queue.hpp"
+
+namespace Play
+{
+
+// What picks a message's worker mailbox.
+enum class DispatchKey
+{
+    // Header::stage_index, so every message of a stage meets one worker
+    StageIndex,
+    // the session id, so every message of a session meets one worker
+    Sid
+};
+
+struct StageDispatchConfig
+{
+    // worker mailboxes, zero delivers everything to the socket's own queue
+    size_t workers = 0;
+    DispatchKey key = DispatchKey::StageIndex;
+};
+
+// Routes inbound messages to one ReceiveQueue per worker thread, so a
+// worker owns its stages outright and sees their messages in order. Each
+// mailbox is sharded by I/O thread like the socket's own queue. CONNECT
+// and DISCONNECT go to every mailbox a session's messages can reach: all
+// of them when dispatching by stage, the session's own when by sid.
+class StageDispatcher
+{
+private:
+    DispatchKey _key;
+    std::vector<std::unique_ptr<ReceiveQueue>> _mailboxes;
+
+public:
+    StageDispatcher(const StageDispatchConfig &config, size_t shards)
+        : _key(config.key)
+    {
+        size_t workers = config.workers > 0 ? config.workers : 1;
+        _mailboxes.reserve(workers);
+        for (size_t i = 0; i < workers; i++)
+        {
+            _mailboxes.push_back(std::make_unique<ReceiveQueue>(shards));
+        }
+    }
+
+    size_t workers() const
+    {
+        return _mailboxes.size();
+    }
+
+    ReceiveQueue &mailbox(size_t worker)
+    {
+        return *_mailboxes[worker];
+    }
+
+    size_t mailboxFor(const ClientMessage &message) const
+    {
+        if (_key == DispatchKey::Sid)
+        {
+            return static_cast<uint64_t>(message.sid()) % _mailboxes.size();
+        }
+        return static_cast<uint8_t>(message.header().stage_index) %
+               _mailboxes.size();
+    }
+
+    // `shard` is the producing I/O thread's shard, see ReceiveQueue
+    void push(size_t shard, std::unique_ptr<ClientMessage> message)
+    {
+        bool lifecycle = message->type() == MessageType::CONNECT ||
+                         message->type() == MessageType::DISCONNECT;
+        if (!lifecycle || _key == DispatchKey::Sid)
+        {
+            size_t worker = mailboxFor(*message);
+            _mailboxes[worker]->push(shard, std::move(message));
+            return;
+        }
+
+        for (size_t i = 0; i + 1 < _mailboxes.size(); i++)
+        {
+            _mailboxes[i]->push(
+                shard,
+                std::make_unique<ClientMessage>(message->sid(),
+                                                message->type()));
+        }
+        _mailboxes.back()->push(shard, std::move(message));
+    }
+};
+
+} // namespace Play
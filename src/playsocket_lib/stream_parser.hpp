@@ -1,74 +1,396 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstring>
 #include <iostream>
 #include <list>
+#include <vector>
 
 #include "bit_converter.hpp"
+#include "buffer_pool.hpp"
 #include "client_message.hpp"
+#include "header_codec.hpp"
 #include "logger_interface.hpp"
+#include "mirrored_ring_buffer.hpp"
 #include "ring_buffer.hpp"
 
 namespace Play
 {
 
-const int MAX_PACKET_SIZE = 65535;
-const int HEADER_SIZE = 11;
+const int HEADER_SIZE = static_cast<int>(ClientHeaderCodec::SIZE);
 
-class StreamParser
+const size_t PARSER_BUFFER_CAPACITY = 1024 * 8;
+const size_t PARSER_BUFFER_MAX_CAPACITY = 1024 * 64 * 8;
+
+// When an idle session parser gives its buffer memory back.
+struct BufferReclaimPolicy
+{
+    // a buffer holding at most this many bytes shrinks to its base capacity
+    size_t lowWatermark = PARSER_BUFFER_CAPACITY;
+    // how long a parser must go without receiving data before reclaiming
+    std::chrono::milliseconds idleTimeout{30 * 1000};
+    // free the storage entirely once the buffer is empty and idle
+    bool releaseWhenEmpty = true;
+    // how often the owning socket sweeps its sessions, zero disables it
+    std::chrono::milliseconds sweepInterval{5 * 1000};
+};
+
+// Process-wide gauge of the memory held by session parser buffers. Buffers
+// go back to the BufferPool, which keeps freed blocks up to its depot limit
+// resident, so pool() is reported next to bytes().
+class ParserBufferStats
+{
+public:
+    static int64_t bytes()
+    {
+        return _bytes.load(std::memory_order_relaxed);
+    }
+
+    static int64_t parsers()
+    {
+        return _parsers.load(std::memory_order_relaxed);
+    }
+
+    // the pool the buffers draw from, see BufferPool::Stats
+    static BufferPool::Stats pool()
+    {
+        return BufferPool::instance().stats();
+    }
+
+    static void add(int64_t bytes, int64_t parsers)
+    {
+        _bytes.fetch_add(bytes, std::memory_order_relaxed);
+        _parsers.fetch_add(parsers, std::memory_order_relaxed);
+    }
+
+private:
+    inline static std::atomic<int64_t> _bytes{0};
+    inline static std::atomic<int64_t> _parsers{0};
+};
+
+// Receives each decoded message as soon as its frame is complete.
+template <typename Sink>
+concept MessageSink = std::invocable<Sink, std::unique_ptr<ClientMessage>>;
+
+struct VectorSink
+{
+    std::vector<std::unique_ptr<ClientMessage>> &messages;
+
+    void operator()(std::unique_ptr<ClientMessage> message) const
+    {
+        messages.push_back(std::move(message));
+    }
+};
+
+template <typename Buffer>
+class BasicStreamParser
 {
 private:
     int64_t _sid = 0;
-    RingBuffer _buffer{1024 * 8, 1024 * 64 * 8};
+    Buffer _buffer{PARSER_BUFFER_CAPACITY, PARSER_BUFFER_MAX_CAPACITY};
+    BufferReclaimPolicy _policy;
+    std::chrono::steady_clock::time_point _lastActivity;
+    size_t _accountedBytes = 0;
 
 public:
-    StreamParser(int64_t sid) : _sid(sid)
+    BasicStreamParser(int64_t sid, const BufferReclaimPolicy &policy = {})
+        : _sid(sid), _policy(policy),
+          _lastActivity(std::chrono::steady_clock::now())
+    {
+        ParserBufferStats::add(0, 1);
+        updateStats();
+    }
+
+    BasicStreamParser(const BasicStreamParser &) = delete;
+    BasicStreamParser &operator=(const BasicStreamParser &) = delete;
+
+    ~BasicStreamParser()
     {
+        ParserBufferStats::add(-static_cast<int64_t>(_accountedBytes), -1);
     }
 
     void write(const unsigned char *buffer, size_t offset, size_t count)
     {
+        ensureStorage();
         _buffer.write(buffer, offset, count);
+        touch();
     }
-    std::list<std::unique_ptr<ClientMessage>> parse()
+
+    // lets a transport receive straight into the parser's free space instead
+    // of handing over a buffer that write() has to copy
+    std::array<std::span<unsigned char>, 2> writableSpans(size_t minimum)
     {
-        auto messages = std::list<std::unique_ptr<ClientMessage>>();
+        ensureStorage();
+        auto spans = _buffer.writableSpans(minimum);
+        updateStats();
+        return spans;
+    }
+
+    void commitWrite(size_t count)
+    {
+        _buffer.commitWrite(count);
+        touch();
+    }
+
+    size_t bufferCapacity() const
+    {
+        return _buffer.capacity();
+    }
+
+    // gives buffer memory back once the parser has been idle for the policy's
+    // timeout: an empty buffer is released, a buffer at or below the low
+    // watermark shrinks to its base capacity. returns true if storage went
+    // back to the BufferPool
+    bool reclaim(std::chrono::steady_clock::time_point now)
+    {
+        if (now - _lastActivity < _policy.idleTimeout)
+        {
+            return false;
+        }
+
+        size_t before = _buffer.allocatedBytes();
+
+        if (_buffer.size() == 0 && _policy.releaseWhenEmpty)
+        {
+            _buffer.release();
+        }
+        else if (_buffer.capacity() > PARSER_BUFFER_CAPACITY &&
+                 _buffer.size() <= _policy.lowWatermark)
+        {
+            _buffer.resizeBuffer(
+                std::max(PARSER_BUFFER_CAPACITY, _buffer.size()));
+        }
 
+        updateStats();
+        return _buffer.allocatedBytes() < before;
+    }
+
+    // emits every complete frame buffered in the ring to `sink`
+    template <MessageSink Sink>
+    void parse(Sink &&sink)
+    {
         while (_buffer.size() >= HEADER_SIZE)
         {
-            uint16_t body_size = static_cast<uint16_t>(
-                BitConverter::toHost(_buffer.peekInt16()));
+            uint16_t body_size = peekBodySize();
+            checkBodySize(body_size);
 
-            if (body_size > MAX_PACKET_SIZE)
+            if (_buffer.size() < body_size + HEADER_SIZE)
             {
-                Log::error(std::format("body size is over : {}", body_size),
-                           typeid(this).name());
-                throw std::out_of_range("body size is over");
+                return;
             }
 
-            if (_buffer.size() < body_size + HEADER_SIZE)
+            sink(readMessage(body_size));
+        }
+    }
+
+    // write() followed by parse(sink), except that whole frames are decoded
+    // straight out of `buffer` while the ring is empty: only a frame left
+    // pending from an earlier call and the trailing partial frame are copied
+    // into the ring
+    template <MessageSink Sink>
+    void parse(const unsigned char *buffer,
+               size_t offset,
+               size_t count,
+               Sink &&sink)
+    {
+        const unsigned char *data = buffer + offset;
+
+        // top up the pending frame with just the bytes it is missing
+        while (_buffer.size() > 0 && count > 0)
+        {
+            size_t take = std::min(missingBytes(), count);
+            write(data, 0, take);
+            data += take;
+            count -= take;
+
+            if (missingBytes() == 0)
             {
-                return messages;
+                sink(readMessage(peekBodySize()));
             }
-            _buffer.clear(2);
+        }
 
-            int16_t service_id = BitConverter::toHost(_buffer.readInt16());
+        while (count >= HEADER_SIZE)
+        {
+            uint16_t body_size = ClientHeaderCodec::peekBodySize(data);
+            checkBodySize(body_size);
 
-            int32_t msg_id = BitConverter::toHost(_buffer.readInt32());
+            size_t frame_size = body_size + HEADER_SIZE;
+            if (count < frame_size)
+            {
+                break;
+            }
 
-            int16_t msg_seq = BitConverter::toHost(_buffer.readInt16());
+            sink(decodeFrame(data, body_size));
+            data += frame_size;
+            count -= frame_size;
+        }
 
-            int8_t stage_index = _buffer.readInt8();
+        if (count > 0)
+        {
+            write(data, 0, count);
+        }
+        else
+        {
+            touch();
+        }
+    }
 
-            auto body = std::make_unique<zmq::message_t>(body_size);
-            _buffer.read(static_cast<uint8_t *>(body->data()), 0, body_size);
+    // appends to `messages`, which callers can reuse across calls
+    void parse(std::vector<std::unique_ptr<ClientMessage>> &messages)
+    {
+        parse(VectorSink{messages});
+    }
 
-            auto message = std::make_unique<ClientMessage>(
-                _sid,
-                Header(service_id, msg_id, msg_seq, stage_index),
-                std::move(body));
+    void parse(const unsigned char *buffer,
+               size_t offset,
+               size_t count,
+               std::vector<std::unique_ptr<ClientMessage>> &messages)
+    {
+        parse(buffer, offset, count, VectorSink{messages});
+    }
 
+    std::list<std::unique_ptr<ClientMessage>> parse()
+    {
+        auto messages = std::list<std::unique_ptr<ClientMessage>>();
+        parse([&messages](std::unique_ptr<ClientMessage> message) {
             messages.push_back(std::move(message));
-        }
+        });
+        return messages;
+    }
+
+    std::list<std::unique_ptr<ClientMessage>> parse(
+        const unsigned char *buffer,
+        size_t offset,
+        size_t count)
+    {
+        auto messages = std::list<std::unique_ptr<ClientMessage>>();
+        parse(buffer,
+              offset,
+              count,
+              [&messages](std::unique_ptr<ClientMessage> message) {
+                  messages.push_back(std::move(message));
+              });
         return messages;
     }
+
+private:
+    void ensureStorage()
+    {
+        if (_buffer.capacity() == 0)
+        {
+            _buffer.resizeBuffer(PARSER_BUFFER_CAPACITY);
+        }
+    }
+
+    void touch()
+    {
+        _lastActivity = std::chrono::steady_clock::now();
+        updateStats();
+    }
+
+    void updateStats()
+    {
+        size_t allocated = _buffer.allocatedBytes();
+        if (allocated != _accountedBytes)
+        {
+            ParserBufferStats::add(static_cast<int64_t>(allocated) -
+                                       static_cast<int64_t>(_accountedBytes),
+                                   0);
+            _accountedBytes = allocated;
+        }
+    }
+
+    // the header in place when it is contiguous in the ring, otherwise
+    // stitched together from both readable spans into `scratch`
+    const unsigned char *peekHeader(unsigned char *scratch) const
+    {
+        if constexpr (ContiguousRingBuffer<Buffer>)
+        {
+            return _buffer.data();
+        }
+        else
+        {
+            auto spans = _buffer.readableSpans();
+            if (spans[0].size() >= HEADER_SIZE)
+            {
+                return spans[0].data();
+            }
+
+            std::memcpy(scratch, spans[0].data(), spans[0].size());
+            std::memcpy(scratch + spans[0].size(),
+                        spans[1].data(),
+                        HEADER_SIZE - spans[0].size());
+            return scratch;
+        }
+    }
+
+    uint16_t peekBodySize() const
+    {
+        unsigned char scratch[HEADER_SIZE];
+        return ClientHeaderCodec::peekBodySize(peekHeader(scratch));
+    }
+
+    void checkBodySize(uint16_t body_size) const
+    {
+        if (body_size > MAX_PACKET_SIZE)
+        {
+            Log::error(std::format("body size is over : {}", body_size),
+                       typeid(this).name());
+            throw std::out_of_range("body size is over");
+        }
+    }
+
+    // bytes the ring still needs before it holds a complete frame
+    size_t missingBytes() const
+    {
+        if (_buffer.size() < HEADER_SIZE)
+        {
+            return HEADER_SIZE - _buffer.size();
+        }
+
+        uint16_t body_size = peekBodySize();
+        checkBodySize(body_size);
+        size_t frame_size = body_size + HEADER_SIZE;
+        return frame_size > _buffer.size() ? frame_size - _buffer.size() : 0;
+    }
+
+    std::unique_ptr<ClientMessage> decodeFrame(const unsigned char *frame,
+                                               uint16_t body_size) const
+    {
+        return std::make_unique<ClientMessage>(_sid,
+                                               ClientHeaderCodec::decode(frame),
+                                               frame + HEADER_SIZE,
+                                               body_size);
+    }
+
+    std::unique_ptr<ClientMessage> readMessage(uint16_t body_size)
+    {
+        unsigned char scratch[HEADER_SIZE];
+        auto header = ClientHeaderCodec::decode(peekHeader(scratch));
+        _buffer.consume(HEADER_SIZE);
+
+        if (body_size <= ClientMessage::INLINE_BODY_CAPACITY)
+        {
+            unsigned char body[ClientMessage::INLINE_BODY_CAPACITY];
+            _buffer.read(body, 0, body_size);
+            return std::make_unique<ClientMessage>(
+                _sid, header, body, body_size);
+        }
+
+        auto body = std::make_unique<zmq::message_t>(body_size);
+        _buffer.read(static_cast<uint8_t *>(body->data()), 0, body_size);
+
+        return std::make_unique<ClientMessage>(_sid, header, std::move(body));
+    }
 };
+
+// PLAYSOCKET_MIRRORED_RING_BUFFER opts sessions into the mirrored ring; it
+// needs memfd_create/mmap, so other platforms keep the power-of-two ring.
+#if defined(PLAYSOCKET_MIRRORED_RING_BUFFER) && defined(__linux__)
+using StreamParser = BasicStreamParser<MirroredRingBuffer>;
+#else
+using StreamParser = BasicStreamParser<PowerOfTwoRingBuffer>;
+#endif
+
 } // namespace Play
@@ -1,14 +1,26 @@
 #pragma once
 
+#include <chrono>
 #include <iostream>
+#include <stdexcept>
 #include <server/asio/tcp_server.h>
-#include <tbb/concurrent_hash_map.h>
 #include <tbb/concurrent_queue.h>
 #include <thread>
+#include <vector>
 
 #include "client_message.hpp"
+#include "idle_monitor.hpp"
+#include "io_service.hpp"
 #include "logger_interface.hpp"
+#include "outbound_queue.hpp"
+#include "periodic_timer.hpp"
+#include "receive_queue.hpp"
 #include "ring_buffer.hpp"
+#include "send_coalescer.hpp"
+#include "session_base.hpp"
+#include "session_registry.hpp"
+#include "shared_payload.hpp"
+#include "stage_dispatcher.hpp"
 #include "stream_parser.hpp"
 
 namespace Play
@@ -16,19 +28,16 @@ namespace Play
 
 class StreamSocket;
 
-class Session : public CppServer::Asio::TCPSession
+class Session
+    : public SessionBase<Session, CppServer::Asio::TCPSession, StreamSocket>
 {
-private:
-    int64_t _sid = 0;
-
-    std::shared_ptr<Play::StreamSocket> _socket;
-    std::unique_ptr<Play::StreamParser> _parser;
-
 public:
-    using CppServer::Asio::TCPSession::TCPSession;
+    Session(std::shared_ptr<Play::StreamSocket> socket,
+            const std::shared_ptr<CppServer::Asio::TCPServer> &server);
 
-    explicit Session(std::shared_ptr<Play::StreamSocket> socket,
-                     const std::shared_ptr<CppServer::Asio::TCPServer> &server);
+    using SessionBase::send;
+    // queues one outbound frame under the socket's backpressure policy
+    SendStatus send(std::span<const unsigned char> frame, SendClass sendClass);
 
 protected:
     void onConnected() override;
@@ -40,27 +49,101 @@ protected:
     void onError(int error,
                  const std::string &category,
                  const std::string &message) override;
+
+private:
+    friend class SessionBase;
+
+    std::span<const unsigned char> wire(const SharedPayload &payload) const;
 };
 
 class StreamSocket : public std::enable_shared_from_this<StreamSocket>
 {
 public:
-    friend class Session;
+    template <typename, typename, typename>
+    friend class SessionBase;
     StreamSocket();
     virtual ~StreamSocket();
     void bind(int32_t port);
     void close();
-    bool send(Play::ClientMessage &&message);
+    SendStatus send(Play::ClientMessage &&message,
+                    SendClass sendClass = SendClass::Normal);
+    // sends one payload to every session in `sids` without copying it per
+    // message; returns how many of the sessions queued it
+    size_t broadcast(std::span<const int64_t> sids,
+                     const SharedPayload &payload,
+                     SendClass sendClass = SendClass::Normal);
     std::unique_ptr<Play::ClientMessage> recv();
-
-    void addSession(int64_t sid, std::shared_ptr<Session> session);
+    // drains up to `max` queued messages into `messages`, returns the count
+    size_t recvBatch(std::span<std::unique_ptr<ClientMessage>> messages,
+                     size_t max);
+    // blocks until a message arrives or `timeout` passes (nullptr)
+    std::unique_ptr<ClientMessage> recvWait(std::chrono::milliseconds timeout);
+    // readable when messages arrive on an empty queue, see ReceiveQueue
+    int recvEventFd() const;
+    // drains one I/O thread's shard only, for a consumer per I/O thread;
+    // do not mix with the calls above
+    size_t recvBatch(size_t shard,
+                     std::span<std::unique_ptr<ClientMessage>> messages,
+                     size_t max);
+    size_t ioThreads() const;
+    // with stage dispatch enabled, messages are delivered to the worker
+    // mailboxes instead of the calls above
+    size_t workers() const;
+    ReceiveQueue &workerMailbox(size_t worker);
+
+    // registers a connected session and returns its sid
+    int64_t addSession(std::shared_ptr<Session> session);
     void removeSession(int64_t sid);
 
+    // must be called before bind(), throws std::logic_error after it
+    void setIoConfig(const IoConfig &config);
+    // must be called before bind()
+    void setListenConfig(const ListenConfig &config);
+    // must be called before bind(), throws std::logic_error after it
+    void setStageDispatch(const StageDispatchConfig &config);
+    // must be called before bind()
+    void setBackpressurePolicy(const SendBackpressurePolicy &policy);
+    // must be called before bind()
+    void setSendCoalescingPolicy(const SendCoalescingPolicy &policy);
+    // writes the frames sessions staged since the last flush; call it at
+    // the end of a tick when coalescing is enabled
+    void flushSends();
+    // must be called before bind()
+    void setBufferReclaimPolicy(const BufferReclaimPolicy &policy);
+    void reclaimIdleBuffers();
+    // must be called before bind()
+    void setIdlePolicy(const IdlePolicy &policy);
+    // disconnects idle sessions and sends heartbeats that are due
+    void checkIdleSessions();
+
 private:
-    tbb::concurrent_queue<std::unique_ptr<ClientMessage>> _recvBuffer{};
-    tbb::concurrent_hash_map<int64_t, std::shared_ptr<Session>> _sessions{};
+    IoConfig _ioConfig{};
+    ListenConfig _listenConfig{};
+    std::unique_ptr<ReceiveQueue> _recvBuffer;
+    StageDispatchConfig _dispatchConfig{};
+    std::unique_ptr<StageDispatcher> _dispatcher;
+    SessionRegistry<Session> _sessions;
     std::shared_ptr<CppServer::Asio::Service> _service;
-    std::shared_ptr<CppServer::Asio::TCPServer> _server;
+    // one per acceptor, see ListenConfig
+    std::vector<std::shared_ptr<CppServer::Asio::TCPServer>> _servers;
+
+    BufferReclaimPolicy _reclaimPolicy{};
+    std::shared_ptr<PeriodicTimer> _reclaimTimer;
+
+    SendCoalescingPolicy _sendPolicy{};
+    SendBackpressurePolicy _backpressurePolicy{};
+    // sessions with staged frames waiting for a flush
+    tbb::concurrent_queue<int64_t> _stagedSessions;
+    std::shared_ptr<PeriodicTimer> _flushTimer;
+
+    IdleMonitor<Session> _idle;
+    std::shared_ptr<PeriodicTimer> _idleTimer;
+
+    // throws once bind() has started the I/O threads
+    void requireUnbound(const char *setter) const;
+    void createQueues();
+    // hands an inbound message to the receive queue or a worker mailbox
+    void deliver(size_t shard, std::unique_ptr<ClientMessage> message);
 };
 
 
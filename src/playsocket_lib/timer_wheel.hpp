@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Play
+{
+
+// Hierarchical timing wheel keyed by an integer id, in whole ticks. LEVELS
+// wheels of SLOTS slots each cover SLOTS^LEVELS ticks; level 0 has a slot
+// per tick and each level above it a slot per whole turn of the one below.
+// Scheduling is O(1), and an entry cascades down at most LEVELS - 1 times
+// before it fires. Later deadlines are parked in the top level and
+// rescheduled when they come round.
+//
+// There is no cancel: owners check whether a fired entry still applies and
+// schedule it again when its deadline moved, which keeps a deadline reset
+// free of any wheel work. Not thread safe.
+template <typename Key>
+class TimerWheel
+{
+public:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr uint64_t SLOTS = uint64_t{1} << SLOT_BITS;
+    static constexpr unsigned LEVELS = 4;
+    static constexpr uint64_t RANGE = uint64_t{1} << (SLOT_BITS * LEVELS);
+
+    explicit TimerWheel(uint64_t now = 0) : _current(now)
+    {
+    }
+
+    // the next tick advance() will process
+    uint64_t current() const
+    {
+        return _current;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    // a deadline already passed fires on the next tick processed
+    void schedule(Key key, uint64_t deadline)
+    {
+        _size++;
+        place({key, deadline < _current ? _current : deadline});
+    }
+
+    // processes every tick up to and including `now`, calling
+    // fire(key, deadline) for each entry that is due; fire() may schedule
+    template <typename Fire>
+    void advance(uint64_t now, Fire &&fire)
+    {
+        while (_current <= now)
+        {
+            uint64_t tick = _current;
+
+            for (unsigned level = 1; level < LEVELS; level++)
+            {
+                // a lower level wrapped: pull the next slot of this one down
+                if (slotOf(tick, level - 1) != 0)
+                {
+                    break;
+                }
+                cascade(level, slotOf(tick, level));
+            }
+
+            std::vector<Entry> due;
+            due.swap(_wheels[0][slotOf(tick, 0)]);
+            // entries fire() schedules for this tick go to the next one
+            _current++;
+            for (Entry &entry : due)
+            {
+                if (entry.deadline > tick)
+                {
+                    // parked past the range, not due yet
+                    place(entry);
+                    continue;
+                }
+                _size--;
+                fire(entry.key, entry.deadline);
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Key key;
+        uint64_t deadline;
+    };
+
+    std::array<std::array<std::vector<Entry>, SLOTS>, LEVELS> _wheels;
+    uint64_t _current;
+    size_t _size = 0;
+
+    static size_t slotOf(uint64_t tick, unsigned level)
+    {
+        return static_cast<size_t>((tick >> (SLOT_BITS * level)) &
+                                   (SLOTS - 1));
+    }
+
+    void place(const Entry &entry)
+    {
+        uint64_t delta = entry.deadline - _current;
+        uint64_t at = delta < RANGE ? entry.deadline : _current + RANGE - 1;
+
+        unsigned level = 0;
+        while (level + 1 < LEVELS &&
+               (at - _current) >= (uint64_t{1} << (SLOT_BITS * (level + 1))))
+        {
+            level++;
+        }
+        _wheels[level][slotOf(at, level)].push_back(entry);
+    }
+
+    void cascade(unsigned level, size_t slot)
+    {
+        std::vector<Entry> entries;
+        entries.swap(_wheels[level][slot]);
+        for (const Entry &entry : entries)
+        {
+            place(entry);
+        }
+    }
+};
+
+} // namespace Play
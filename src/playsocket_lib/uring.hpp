@@ -0,0 +1,311 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Play
+{
+
+// Minimal io_uring ring on the kernel interface: the submission and
+// completion rings and preparation of the few operations UringStreamSocket
+// issues. Only the thread that owns the ring may use it.
+class Uring
+{
+public:
+    Uring() = default;
+
+    Uring(const Uring &) = delete;
+    Uring &operator=(const Uring &) = delete;
+
+    ~Uring()
+    {
+        close();
+    }
+
+    // sets the ring up with at least `entries` submission entries; throws
+    // a runtime_error naming the failing call
+    void open(unsigned entries, unsigned flags)
+    {
+        io_uring_params params{};
+        params.flags = flags;
+        int fd = static_cast<int>(
+            syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+        {
+            throw error("io_uring_setup", errno);
+        }
+        _fd = fd;
+
+        try
+        {
+            map(params);
+        }
+        catch (...)
+        {
+            close();
+            throw;
+        }
+    }
+
+    void close()
+    {
+        if (_sqes != nullptr)
+        {
+            munmap(_sqes, _sqesBytes);
+            _sqes = nullptr;
+        }
+        if (_cqRing != nullptr && _cqRing != _sqRing)
+        {
+            munmap(_cqRing, _cqRingBytes);
+        }
+        _cqRing = nullptr;
+        if (_sqRing != nullptr)
+        {
+            munmap(_sqRing, _sqRingBytes);
+            _sqRing = nullptr;
+        }
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+
+    bool isOpen() const
+    {
+        return _fd >= 0;
+    }
+
+    // the next free submission entry, cleared, or nullptr when the
+    // submission queue is full
+    io_uring_sqe *nextSqe()
+    {
+        unsigned head = load(_sq.head);
+        if (_sqTail - head >= _sq.entries)
+        {
+            return nullptr;
+        }
+
+        unsigned index = _sqTail & _sq.mask;
+        _sq.array[index] = index;
+        _sqTail++;
+
+        io_uring_sqe *sqe = &_sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // hands every prepared entry to the kernel and, when `wait` is set,
+    // blocks until that many completions are in; returns the number
+    // submitted or -errno
+    int submit(unsigned wait = 0)
+    {
+        store(_sq.tail, _sqTail);
+        unsigned pending = _sqTail - load(_sq.head);
+        unsigned flags = wait > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int result = static_cast<int>(syscall(
+            __NR_io_uring_enter, _fd, pending, wait, flags, nullptr, 0));
+        return result < 0 ? -errno : result;
+    }
+
+    // calls fn(const io_uring_cqe &) for every completion that is in and
+    // frees their slots, returns how many there were
+    template <typename Fn>
+    unsigned reap(Fn &&fn)
+    {
+        unsigned head = *_cq.head;
+        unsigned tail = load(_cq.tail);
+        unsigned count = tail - head;
+        for (; head != tail; head++)
+        {
+            fn(_cq.cqes[head & _cq.mask]);
+        }
+        store(_cq.head, head);
+        return count;
+    }
+
+    static void prepMultishotAccept(io_uring_sqe *sqe, int fd, int flags)
+    {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = fd;
+        sqe->accept_flags = static_cast<uint32_t>(flags);
+        sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+    }
+
+    static void prepPollMultishot(io_uring_sqe *sqe, int fd, uint32_t events)
+    {
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        // the kernel reads the 32-bit mask as two swapped halves on
+        // big-endian hosts
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            events = events << 16 | events >> 16;
+        }
+        sqe->poll32_events = events;
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+
+    // hands `count` buffers of `size` bytes laid out back to back at `data`
+    // to buffer group `group`, numbered from `firstId`; only a failure
+    // posts a completion
+    static void prepProvideBuffers(io_uring_sqe *sqe,
+                                   void *data,
+                                   unsigned size,
+                                   unsigned count,
+                                   uint16_t group,
+                                   uint16_t firstId)
+    {
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int32_t>(count);
+        sqe->addr = reinterpret_cast<uint64_t>(data);
+        sqe->len = size;
+        sqe->off = firstId;
+        sqe->buf_group = group;
+        sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+    }
+
+    // receives into buffers of `group` until the connection ends
+    static void prepRecvMultishot(io_uring_sqe *sqe, int fd, uint16_t group)
+    {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->ioprio |= IORING_RECV_MULTISHOT;
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = group;
+    }
+
+    static void prepSendmsg(io_uring_sqe *sqe,
+                            int fd,
+                            const msghdr *message,
+                            int flags)
+    {
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(message);
+        sqe->len = 1;
+        sqe->msg_flags = static_cast<uint32_t>(flags);
+    }
+
+private:
+    struct SubmissionRing
+    {
+        unsigned *head = nullptr;
+        unsigned *tail = nullptr;
+        unsigned *array = nullptr;
+        unsigned mask = 0;
+        unsigned entries = 0;
+    };
+
+    struct CompletionRing
+    {
+        unsigned *head = nullptr;
+        unsigned *tail = nullptr;
+        io_uring_cqe *cqes = nullptr;
+        unsigned mask = 0;
+    };
+
+    int _fd = -1;
+    void *_sqRing = nullptr;
+    void *_cqRing = nullptr;
+    size_t _sqRingBytes = 0;
+    size_t _cqRingBytes = 0;
+    io_uring_sqe *_sqes = nullptr;
+    size_t _sqesBytes = 0;
+    SubmissionRing _sq;
+    CompletionRing _cq;
+    // prepared entries, published to the kernel by submit()
+    unsigned _sqTail = 0;
+
+    static std::runtime_error error(const char *what, int code)
+    {
+        return std::runtime_error(
+            std::format("{} failed: {}", what, std::strerror(code)));
+    }
+
+    // the ring indices are shared with the kernel
+    static unsigned load(unsigned *value)
+    {
+        return std::atomic_ref<unsigned>(*value).load(
+            std::memory_order_acquire);
+    }
+
+    static void store(unsigned *value, unsigned next)
+    {
+        std::atomic_ref<unsigned>(*value).store(next,
+                                                std::memory_order_release);
+    }
+
+    static void *mapRing(int fd, size_t size, off_t offset)
+    {
+        void *mapped = mmap(nullptr,
+                            size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            fd,
+                            offset);
+        if (mapped == MAP_FAILED)
+        {
+            throw error("mmap", errno);
+        }
+        return mapped;
+    }
+
+    template <typename T>
+    static T *at(void *ring, uint32_t offset)
+    {
+        return reinterpret_cast<T *>(static_cast<unsigned char *>(ring) +
+                                     offset);
+    }
+
+    void map(const io_uring_params &params)
+    {
+        _sqRingBytes =
+            params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cqRingBytes =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        // one mapping covers both rings on kernels since 5.4
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single)
+        {
+            _sqRingBytes = std::max(_sqRingBytes, _cqRingBytes);
+            _cqRingBytes = _sqRingBytes;
+        }
+
+        _sqRing = mapRing(_fd, _sqRingBytes, IORING_OFF_SQ_RING);
+        _cqRing = single ? _sqRing
+                         : mapRing(_fd, _cqRingBytes, IORING_OFF_CQ_RING);
+        _sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe *>(
+            mapRing(_fd, _sqesBytes, IORING_OFF_SQES));
+
+        _sq.head = at<unsigned>(_sqRing, params.sq_off.head);
+        _sq.tail = at<unsigned>(_sqRing, params.sq_off.tail);
+        _sq.array = at<unsigned>(_sqRing, params.sq_off.array);
+        _sq.mask = *at<unsigned>(_sqRing, params.sq_off.ring_mask);
+        _sq.entries = *at<unsigned>(_sqRing, params.sq_off.ring_entries);
+        _sqTail = *_sq.tail;
+
+        _cq.head = at<unsigned>(_cqRing, params.cq_off.head);
+        _cq.tail = at<unsigned>(_cqRing, params.cq_off.tail);
+        _cq.cqes = at<io_uring_cqe>(_cqRing, params.cq_off.cqes);
+        _cq.mask = *at<unsigned>(_cqRing, params.cq_off.ring_mask);
+    }
+};
+
+} // namespace Play
+
+#endif
@@ -0,0 +1,598 @@
+#include "uring_stream_socket.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace Play;
+
+struct UringStreamSocket::Connection
+{
+    int fd = -1;
+    int64_t sid = 0;
+    std::unique_ptr<StreamParser> parser;
+
+    // payloads waiting to be sent, the first one possibly in part
+    std::deque<SharedPayload> queued;
+    size_t sentOffset = 0;
+    // the sendmsg in flight points into these
+    std::vector<iovec> iov;
+    msghdr message{};
+
+    bool recvArmed = false;
+    bool sending = false;
+    bool closing = false;
+};
+
+namespace
+{
+
+uint64_t userData(void *connection, uint64_t operation)
+{
+    return reinterpret_cast<uint64_t>(connection) | operation;
+}
+
+std::runtime_error systemError(const char *what, int error)
+{
+    return std::runtime_error(
+        std::format("{} failed: {}", what, std::strerror(error)));
+}
+
+} // namespace
+
+UringStreamSocket::UringStreamSocket()
+{
+}
+
+UringStreamSocket::~UringStreamSocket()
+{
+    close();
+}
+
+void UringStreamSocket::setConfig(const UringConfig &config)
+{
+    _config = config;
+}
+
+void UringStreamSocket::setBufferReclaimPolicy(
+    const BufferReclaimPolicy &policy)
+{
+    _reclaimPolicy = policy;
+}
+
+void UringStreamSocket::bind(int32_t port)
+{
+    // buffer ids are 16 bits wide
+    if (_config.recvBuffers == 0 || _config.recvBuffers > 65536)
+    {
+        throw std::invalid_argument("recvBuffers must be 1 to 65536");
+    }
+
+    try
+    {
+        _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_wakeFd < 0)
+        {
+            throw systemError("eventfd", errno);
+        }
+
+        _listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (_listenFd < 0)
+        {
+            throw systemError("socket", errno);
+        }
+        int enable = 1;
+        ::setsockopt(_listenFd,
+                     SOL_SOCKET,
+                     SO_REUSEADDR,
+                     &enable,
+                     sizeof(enable));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (::bind(_listenFd,
+                   reinterpret_cast<sockaddr *>(&address),
+                   sizeof(address)) < 0)
+        {
+            throw systemError("bind", errno);
+        }
+        if (::listen(_listenFd, SOMAXCONN) < 0)
+        {
+            throw systemError("listen", errno);
+        }
+
+        // COOP_TASKRUN (5.19, older than multishot recv) keeps completions
+        // from interrupting the ring thread; their work runs when it next
+        // enters the kernel, which it does every round anyway
+        _ring.open(_config.entries, IORING_SETUP_COOP_TASKRUN);
+
+        _bufferMemory.resize(static_cast<size_t>(_config.recvBuffers) *
+                             _config.recvBufferSize);
+        // goes out with the first submission, ahead of any recv
+        io_uring_sqe *sqe = nextSqe();
+        Uring::prepProvideBuffers(sqe,
+                                  bufferAt(0),
+                                  _config.recvBufferSize,
+                                  _config.recvBuffers,
+                                  BUFFER_GROUP,
+                                  0);
+        sqe->user_data = userData(nullptr, PROVIDE);
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+
+    _running.store(true, std::memory_order_release);
+    _thread = std::thread([this]() { run(); });
+
+    Log::info("uring stream server start!", typeid(this).name());
+}
+
+void UringStreamSocket::close()
+{
+    if (_running.exchange(false, std::memory_order_acq_rel))
+    {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(_wakeFd, &one, sizeof(one));
+        _thread.join();
+
+        // the same notice the Asio backend gives when its server stops
+        for (auto &[sid, connection] : _connections)
+        {
+            if (!connection->closing)
+            {
+                _recvBuffer.push(std::make_unique<ClientMessage>(
+                    sid,
+                    MessageType::DISCONNECT));
+            }
+        }
+    }
+    release();
+}
+
+SendStatus UringStreamSocket::send(ClientMessage &&message,
+                                   SendClass sendClass)
+{
+    auto guard = _sessions.pin();
+    if (_sessions.find(message.sid(), guard) == nullptr)
+    {
+        Log::debug(std::format("session is not exist {}", message.sid()),
+                   typeid(this).name());
+        return SendStatus::UnknownSession;
+    }
+
+    _outbox.push({message.sid(), SharedPayload(message.bodyView())});
+    wake();
+    return SendStatus::Queued;
+}
+
+size_t UringStreamSocket::broadcast(std::span<const int64_t> sids,
+                                    const SharedPayload &payload,
+                                    SendClass sendClass)
+{
+    size_t sent = 0;
+    auto guard = _sessions.pin();
+    for (int64_t sid : sids)
+    {
+        if (_sessions.find(sid, guard) != nullptr)
+        {
+            _outbox.push({sid, payload});
+            sent++;
+        }
+    }
+    if (sent > 0)
+    {
+        wake();
+    }
+    return sent;
+}
+
+std::unique_ptr<ClientMessage> UringStreamSocket::recv()
+{
+    return _recvBuffer.tryPop();
+}
+
+size_t UringStreamSocket::recvBatch(
+    std::span<std::unique_ptr<ClientMessage>> messages,
+    size_t max)
+{
+    return _recvBuffer.popBatch(messages, max);
+}
+
+std::unique_ptr<ClientMessage> UringStreamSocket::recvWait(
+    std::chrono::milliseconds timeout)
+{
+    return _recvBuffer.waitPop(timeout);
+}
+
+int UringStreamSocket::recvEventFd() const
+{
+    return _recvBuffer.eventFd();
+}
+
+void UringStreamSocket::run()
+{
+    armAccept();
+    armWake();
+
+    while (_running.load(std::memory_order_acquire))
+    {
+        // one submission for every send, recv and rearm queued since the
+        // last round
+        int result = _ring.submit(1);
+        if (result < 0 && result != -EINTR)
+        {
+            Log::error(std::format("io_uring wait failed: {}",
+                                   std::strerror(-result)),
+                       typeid(this).name());
+            break;
+        }
+
+        _ring.reap([this](const io_uring_cqe &cqe) { handle(cqe); });
+
+        // picks up sends queued while this round ran without another wake
+        drainOutbox();
+    }
+}
+
+void UringStreamSocket::handle(const io_uring_cqe &cqe)
+{
+    uint64_t data = cqe.user_data;
+    auto *connection =
+        reinterpret_cast<Connection *>(data & ~OPERATION_MASK);
+
+    switch (data & OPERATION_MASK)
+    {
+    case ACCEPT:
+        onAccept(cqe);
+        break;
+    case WAKE:
+        onWake(cqe);
+        break;
+    case RECV:
+        onRecv(*connection, cqe);
+        break;
+    case SEND:
+        onSend(*connection, cqe);
+        break;
+    case PROVIDE:
+        onProvide(cqe);
+        break;
+    }
+}
+
+io_uring_sqe *UringStreamSocket::nextSqe()
+{
+    io_uring_sqe *sqe = _ring.nextSqe();
+    while (sqe == nullptr)
+    {
+        // the submission queue is full, hand it to the kernel early
+        _ring.submit();
+        sqe = _ring.nextSqe();
+    }
+    return sqe;
+}
+
+void UringStreamSocket::armAccept()
+{
+    io_uring_sqe *sqe = nextSqe();
+    Uring::prepMultishotAccept(sqe, _listenFd, SOCK_CLOEXEC);
+    sqe->user_data = userData(nullptr, ACCEPT);
+}
+
+void UringStreamSocket::armWake()
+{
+    io_uring_sqe *sqe = nextSqe();
+    Uring::prepPollMultishot(sqe, _wakeFd, POLLIN);
+    sqe->user_data = userData(nullptr, WAKE);
+}
+
+void UringStreamSocket::armRecv(Connection &connection)
+{
+    io_uring_sqe *sqe = nextSqe();
+    Uring::prepRecvMultishot(sqe, connection.fd, BUFFER_GROUP);
+    sqe->user_data = userData(&connection, RECV);
+    connection.recvArmed = true;
+}
+
+void UringStreamSocket::onAccept(const io_uring_cqe &cqe)
+{
+    if (cqe.res >= 0)
+    {
+        openConnection(cqe.res);
+    }
+    else if (cqe.res != -ECANCELED)
+    {
+        Log::error(std::format("accept failed: {}", std::strerror(-cqe.res)),
+                   typeid(this).name());
+    }
+
+    if (!(cqe.flags & IORING_CQE_F_MORE) &&
+        _running.load(std::memory_order_acquire))
+    {
+        armAccept();
+    }
+}
+
+void UringStreamSocket::onWake(const io_uring_cqe &cqe)
+{
+    uint64_t count = 0;
+    [[maybe_unused]] auto read = ::read(_wakeFd, &count, sizeof(count));
+    // cleared before draining: a send queued after the drain started
+    // wakes the ring again
+    _wakePending.store(false, std::memory_order_release);
+    drainOutbox();
+
+    if (!(cqe.flags & IORING_CQE_F_MORE) &&
+        _running.load(std::memory_order_acquire))
+    {
+        armWake();
+    }
+}
+
+void UringStreamSocket::onRecv(Connection &connection,
+                               const io_uring_cqe &cqe)
+{
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    if (!more)
+    {
+        connection.recvArmed = false;
+    }
+
+    if (cqe.res > 0)
+    {
+        unsigned bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+        if (!connection.closing)
+        {
+            try
+            {
+                connection.parser->parse(
+                    bufferAt(bufferId),
+                    0,
+                    static_cast<size_t>(cqe.res),
+                    [this](std::unique_ptr<ClientMessage> message) {
+                        _recvBuffer.push(std::move(message));
+                    });
+            }
+            catch (std::exception &)
+            {
+                Log::error(std::format("message exception occurred: {}",
+                                       connection.sid),
+                           typeid(this).name());
+                beginClose(connection);
+            }
+        }
+        recycleBuffer(bufferId);
+
+        if (!more && !connection.closing)
+        {
+            armRecv(connection);
+        }
+    }
+    else if (cqe.res == -ENOBUFS)
+    {
+        // every buffer was in use; the ones parsed this round are handed
+        // back in the same submission as the rearmed recv
+        if (!connection.closing)
+        {
+            armRecv(connection);
+        }
+    }
+    else
+    {
+        // 0 when the peer closed, an error otherwise
+        beginClose(connection);
+    }
+
+    releaseIfIdle(connection);
+}
+
+void UringStreamSocket::onSend(Connection &connection,
+                               const io_uring_cqe &cqe)
+{
+    connection.sending = false;
+
+    if (cqe.res < 0)
+    {
+        beginClose(connection);
+    }
+    else
+    {
+        auto sent = static_cast<size_t>(cqe.res);
+        while (sent > 0)
+        {
+            size_t left =
+                connection.queued.front().size() - connection.sentOffset;
+            if (sent < left)
+            {
+                connection.sentOffset += sent;
+                break;
+            }
+            sent -= left;
+            connection.queued.pop_front();
+            connection.sentOffset = 0;
+        }
+        flush(connection);
+    }
+
+    releaseIfIdle(connection);
+}
+
+void UringStreamSocket::onProvide(const io_uring_cqe &cqe)
+{
+    // only failures complete, and the buffers they carried are lost
+    Log::error(std::format("providing receive buffers failed: {}",
+                           std::strerror(-cqe.res)),
+               typeid(this).name());
+}
+
+void UringStreamSocket::openConnection(int fd)
+{
+    int enable = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    auto connection = std::make_shared<Connection>();
+    connection->fd = fd;
+    connection->sid = _sessions.insert(connection);
+    connection->parser =
+        std::make_unique<StreamParser>(connection->sid, _reclaimPolicy);
+    _connections.emplace(connection->sid, connection);
+
+    Log::debug(std::format("session connected : {}", connection->sid),
+               typeid(this).name());
+    _recvBuffer.push(
+        std::make_unique<ClientMessage>(connection->sid, MessageType::CONNECT));
+
+    armRecv(*connection);
+}
+
+void UringStreamSocket::beginClose(Connection &connection)
+{
+    if (connection.closing)
+    {
+        return;
+    }
+    connection.closing = true;
+
+    Log::debug(std::format("session disconnected : {}", connection.sid),
+               typeid(this).name());
+    // forgotten first, so sends after the notice find no session
+    _sessions.remove(connection.sid);
+    _recvBuffer.push(std::make_unique<ClientMessage>(connection.sid,
+                                                     MessageType::DISCONNECT));
+
+    // ends the multishot recv and any send in flight; the descriptor is
+    // closed once their completions are in
+    ::shutdown(connection.fd, SHUT_RDWR);
+}
+
+void UringStreamSocket::releaseIfIdle(Connection &connection)
+{
+    if (!connection.closing || connection.recvArmed || connection.sending)
+    {
+        return;
+    }
+
+    ::close(connection.fd);
+    // destroys the connection, so this comes last
+    _connections.erase(connection.sid);
+}
+
+void UringStreamSocket::wake()
+{
+    if (!_wakePending.exchange(true, std::memory_order_acq_rel))
+    {
+        uint64_t one = 1;
+        [[maybe_unused]] auto written = ::write(_wakeFd, &one, sizeof(one));
+    }
+}
+
+void UringStreamSocket::drainOutbox()
+{
+    Outgoing outgoing;
+    std::vector<Connection *> touched;
+    while (_outbox.try_pop(outgoing))
+    {
+        auto found = _connections.find(outgoing.sid);
+        if (found == _connections.end() || found->second->closing)
+        {
+            continue;
+        }
+        Connection *connection = found->second.get();
+        if (connection->queued.empty())
+        {
+            touched.push_back(connection);
+        }
+        connection->queued.push_back(std::move(outgoing.payload));
+    }
+
+    for (Connection *connection : touched)
+    {
+        flush(*connection);
+    }
+}
+
+void UringStreamSocket::flush(Connection &connection)
+{
+    if (connection.sending || connection.closing || connection.queued.empty())
+    {
+        return;
+    }
+
+    connection.iov.clear();
+    size_t offset = connection.sentOffset;
+    for (const SharedPayload &payload : connection.queued)
+    {
+        if (connection.iov.size() == _config.maxSendBatch)
+        {
+            break;
+        }
+        auto bytes = payload.bytes();
+        connection.iov.push_back(
+            {const_cast<unsigned char *>(bytes.data()) + offset,
+             bytes.size() - offset});
+        offset = 0;
+    }
+
+    connection.message = {};
+    connection.message.msg_iov = connection.iov.data();
+    connection.message.msg_iovlen = connection.iov.size();
+
+    io_uring_sqe *sqe = nextSqe();
+    Uring::prepSendmsg(sqe, connection.fd, &connection.message, MSG_NOSIGNAL);
+    sqe->user_data = userData(&connection, SEND);
+    connection.sending = true;
+}
+
+unsigned char *UringStreamSocket::bufferAt(unsigned bufferId)
+{
+    return _bufferMemory.data() +
+           static_cast<size_t>(bufferId) * _config.recvBufferSize;
+}
+
+void UringStreamSocket::recycleBuffer(unsigned bufferId)
+{
+    io_uring_sqe *sqe = nextSqe();
+    Uring::prepProvideBuffers(sqe,
+                              bufferAt(bufferId),
+                              _config.recvBufferSize,
+                              1,
+                              BUFFER_GROUP,
+                              static_cast<uint16_t>(bufferId));
+    sqe->user_data = userData(nullptr, PROVIDE);
+}
+
+void UringStreamSocket::release()
+{
+    for (auto &[sid, connection] : _connections)
+    {
+        ::close(connection->fd);
+    }
+    _connections.clear();
+    _sessions.clear();
+
+    _ring.close();
+    if (_listenFd >= 0)
+    {
+        ::close(_listenFd);
+        _listenFd = -1;
+    }
+    if (_wakeFd >= 0)
+    {
+        ::close(_wakeFd);
+        _wakeFd = -1;
+    }
+}
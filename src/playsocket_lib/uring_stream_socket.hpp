@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <tbb/concurrent_queue.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "client_message.hpp"
+#include "logger_interface.hpp"
+#include "outbound_queue.hpp"
+#include "receive_queue.hpp"
+#include "session_registry.hpp"
+#include "shared_payload.hpp"
+#include "stream_parser.hpp"
+#include "uring.hpp"
+
+namespace Play
+{
+
+struct UringConfig
+{
+    // submission queue entries
+    unsigned entries = 4096;
+    // receive buffers shared by all connections, at most 65536
+    unsigned recvBuffers = 1024;
+    unsigned recvBufferSize = 16 * 1024;
+    // queued payloads gathered into one sendmsg per connection
+    unsigned maxSendBatch = 64;
+};
+
+// StreamSocket on io_uring instead of CppServer's Asio server, with the
+// same bind/send/recv surface so the two can be compared directly. It talks
+// to the kernel through Uring, so it needs no liburing, only Linux 6.0 or
+// later for multishot recv.
+//
+// One ring thread does all the I/O. It keeps a multishot accept on the
+// listening socket and a multishot recv on every connection. The recvs
+// draw from one group of provided buffers and are parsed in place; each
+// buffer is handed back to the kernel right after parsing.
+// send() and broadcast() only queue payloads and wake the ring thread.
+// The ring thread gathers each connection's queued payloads into one
+// sendmsg and submits all connections' sends together.
+class UringStreamSocket
+{
+public:
+    UringStreamSocket();
+    virtual ~UringStreamSocket();
+
+    UringStreamSocket(const UringStreamSocket &) = delete;
+    UringStreamSocket &operator=(const UringStreamSocket &) = delete;
+
+    // must be called before bind()
+    void setConfig(const UringConfig &config);
+    // must be called before bind()
+    void setBufferReclaimPolicy(const BufferReclaimPolicy &policy);
+
+    void bind(int32_t port);
+    void close();
+    // this backend has no backpressure policy, so `sendClass` is unused
+    SendStatus send(ClientMessage &&message,
+                    SendClass sendClass = SendClass::Normal);
+    size_t broadcast(std::span<const int64_t> sids,
+                     const SharedPayload &payload,
+                     SendClass sendClass = SendClass::Normal);
+    std::unique_ptr<ClientMessage> recv();
+    // drains up to `max` queued messages into `messages`, returns the count
+    size_t recvBatch(std::span<std::unique_ptr<ClientMessage>> messages,
+                     size_t max);
+    // blocks until a message arrives or `timeout` passes (nullptr)
+    std::unique_ptr<ClientMessage> recvWait(std::chrono::milliseconds timeout);
+    // readable when messages arrive on an empty queue, see ReceiveQueue
+    int recvEventFd() const;
+
+private:
+    struct Connection;
+
+    // kept in the low bits of a submission's user data, next to the
+    // connection pointer
+    enum Operation : uint64_t
+    {
+        ACCEPT = 0,
+        RECV = 1,
+        SEND = 2,
+        WAKE = 3,
+        PROVIDE = 4
+    };
+    static constexpr uint64_t OPERATION_MASK = 7;
+
+    struct Outgoing
+    {
+        int64_t sid;
+        SharedPayload payload;
+    };
+
+    static constexpr uint16_t BUFFER_GROUP = 0;
+
+    UringConfig _config{};
+    BufferReclaimPolicy _reclaimPolicy{};
+    ReceiveQueue _recvBuffer;
+    // checked by send() on any thread; only the ring thread changes it
+    SessionRegistry<Connection> _sessions;
+    // owned by the ring thread, connections stay until their last
+    // operation completes
+    std::unordered_map<int64_t, std::shared_ptr<Connection>> _connections;
+    tbb::concurrent_queue<Outgoing> _outbox;
+    std::atomic<bool> _wakePending{false};
+    std::atomic<bool> _running{false};
+    std::thread _thread;
+
+    Uring _ring;
+    std::vector<unsigned char> _bufferMemory;
+    int _listenFd = -1;
+    int _wakeFd = -1;
+
+    void run();
+    void handle(const io_uring_cqe &cqe);
+    io_uring_sqe *nextSqe();
+
+    void armAccept();
+    void armWake();
+    void armRecv(Connection &connection);
+
+    void onAccept(const io_uring_cqe &cqe);
+    void onWake(const io_uring_cqe &cqe);
+    void onRecv(Connection &connection, const io_uring_cqe &cqe);
+    void onSend(Connection &connection, const io_uring_cqe &cqe);
+    void onProvide(const io_uring_cqe &cqe);
+
+    void openConnection(int fd);
+    void beginClose(Connection &connection);
+    void releaseIfIdle(Connection &connection);
+
+    void wake();
+    void drainOutbox();
+    void flush(Connection &connection);
+
+    unsigned char *bufferAt(unsigned bufferId);
+    void recycleBuffer(unsigned bufferId);
+    void release();
+};
+
+} // namespace Play
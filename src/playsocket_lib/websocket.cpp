@@ -4,62 +4,44 @@ using namespace Play;
 
 WSSession::WSSession(std::shared_ptr<WSStreamSocket> socket,
                      const std::shared_ptr<CppServer::WS::WSServer> &server)
-    : _streamSocket(socket), CppServer::WS::WSSession(server)
+    : SessionBase(std::move(socket), server)
 {
 }
 
 
 void WSSession::onWSConnected(const CppServer::HTTP::HTTPRequest &request)
 {
-    _sid = static_cast<int64_t>(socket().native_handle());
-    _parser = std::make_unique<StreamParser>(_sid);
-
-    std::shared_ptr<WSSession> session =
-        std::dynamic_pointer_cast<WSSession>(shared_from_this());
-    _streamSocket->addSession(_sid, session);
-
-
-    Log::debug(std::format("session connected : {}", _sid),
-               typeid(this).name());
-    _streamSocket->_recvBuffer.push(
-        std::make_unique<ClientMessage>(_sid, MessageType::CONNECT));
+    opened();
 }
 
 void WSSession::onWSDisconnected()
 {
-    Log::debug(std::format("session disconnected : {}", _sid),
-               typeid(this).name());
-
-    _streamSocket->_recvBuffer.push(
-        std::make_unique<ClientMessage>(_sid, MessageType::DISCONNECT));
-
-    _streamSocket->removeSession(_sid);
+    closed();
 }
 
 void WSSession::onWSReceived(const void *buffer, size_t size)
 {
+    received(buffer, size);
+}
 
-    try
-    {
-        _parser->write(static_cast<const unsigned char *>(buffer), 0, size);
-
-        auto messages = _parser->parse();
+SendStatus WSSession::send(std::span<const unsigned char> body,
+                           SendClass sendClass)
+{
+    WSFrameHeader header = WSFrameHeader::binary(body.size());
+    return submit(header.bytes(), body, sendClass, [body]() {
+        return SharedPayload(body);
+    });
+}
 
-        for (auto &message : messages)
-        {
-            _streamSocket->_recvBuffer.push(std::move(message));
-        }
-    }
-    catch (std::exception ex)
-    {
-        Log::error(std::format("message exception occurred: {}", _sid),
-                   typeid(this).name());
-        Disconnect();
-    }
+std::span<const unsigned char> WSSession::wire(
+    const SharedPayload &payload) const
+{
+    return payload.wsFrame();
 }
 
 void WSSession::onWSPing(const void *buffer, size_t size)
 {
+    markReceived();
     SendPongAsync(buffer, size);
 }
 
@@ -94,6 +76,7 @@ std::shared_ptr<CppServer::Asio::TCPSession> WSStreamServer::CreateSession(
     const std::shared_ptr<CppServer::Asio::TCPServer> &server)
 {
     return std::make_shared<WSSession>(
+        _socket,
         std::dynamic_pointer_cast<CppServer::WS::WSServer>(server));
 }
 
@@ -113,7 +96,7 @@ void WSStreamServer::onError(int32_t error,
 
 ////////////// StreamSocket /////////////////////
 
-WSStreamSocket::WSStreamSocket()
+WSStreamSocket::WSStreamSocket() : _recvBuffer(std::make_unique<ReceiveQueue>())
 {
 }
 WSStreamSocket::~WSStreamSocket()
@@ -121,60 +104,271 @@ WSStreamSocket::~WSStreamSocket()
 }
 void WSStreamSocket::bind(int32_t port)
 {
-    _service = std::make_shared<CppServer::Asio::Service>();
+    _service = std::make_shared<IoService>(_ioConfig);
     _service->Start();
 
     Log::info("stream service start!", typeid(this).name());
 
 
-    _server =
-        std::make_shared<WSStreamServer>(shared_from_this(), _service, port);
+    // listeners spread over the I/O threads, since each server takes the
+    // service's next Asio service for its acceptor
+    int acceptors = _listenConfig.acceptorCount(_ioConfig);
+    for (int i = 0; i < acceptors; i++)
+    {
+        auto server = std::make_shared<WSStreamServer>(shared_from_this(),
+                                                       _service,
+                                                       port);
+        server->SetupReusePort(_listenConfig.sharesPort(_ioConfig));
+        server->Start();
+        _servers.push_back(std::move(server));
+    }
+
+    Log::info(std::format("stream server start! acceptors:{}", acceptors),
+              typeid(this).name());
 
-    _server->Start();
+    if (_reclaimPolicy.sweepInterval.count() > 0)
+    {
+        std::weak_ptr<WSStreamSocket> weak = shared_from_this();
+        _reclaimTimer = std::make_shared<PeriodicTimer>(
+            _service,
+            _reclaimPolicy.sweepInterval,
+            [weak]() {
+                if (auto socket = weak.lock())
+                {
+                    socket->reclaimIdleBuffers();
+                }
+            });
+        _reclaimTimer->start();
+    }
 
-    Log::info("stream server start!", typeid(this).name());
+    if (_sendPolicy.enabled && _sendPolicy.flushDelay.count() > 0)
+    {
+        std::weak_ptr<WSStreamSocket> weak = shared_from_this();
+        _flushTimer = std::make_shared<PeriodicTimer>(
+            _service,
+            _sendPolicy.flushDelay,
+            [weak]() {
+                if (auto socket = weak.lock())
+                {
+                    socket->flushSends();
+                }
+            });
+        _flushTimer->start();
+    }
+
+    if (_idle.enabled())
+    {
+        std::weak_ptr<WSStreamSocket> weak = shared_from_this();
+        _idleTimer = std::make_shared<PeriodicTimer>(
+            _service,
+            _idle.tick(),
+            [weak]() {
+                if (auto socket = weak.lock())
+                {
+                    socket->checkIdleSessions();
+                }
+            });
+        _idleTimer->start();
+    }
 }
 void WSStreamSocket::close()
 {
+    if (_reclaimTimer != nullptr)
+        _reclaimTimer->Cancel();
+
+    if (_flushTimer != nullptr)
+        _flushTimer->Cancel();
+
+    if (_idleTimer != nullptr)
+        _idleTimer->Cancel();
 
-    if (_server != nullptr)
-        _server->Stop();
+    for (auto &server : _servers)
+        server->Stop();
+    _servers.clear();
 
     if (_service != nullptr)
         _service->Stop();
+
+    // sessions hold a reference back to this socket
+    _sessions.clear();
 }
-bool WSStreamSocket::send(Play::ClientMessage &&message)
+SendStatus WSStreamSocket::send(Play::ClientMessage &&message,
+                                SendClass sendClass)
 {
-    tbb::concurrent_hash_map<int64_t,
-                             std::shared_ptr<WSSession>>::const_accessor result;
-    if (_sessions.find(result, message.sid()))
-    {
-        const std::shared_ptr<WSSession> session = result->second;
-        auto msg = message.body();
-        session->SendAsync(msg->data(), msg->size());
-    }
-    else
+    auto guard = _sessions.pin();
+    WSSession *session = _sessions.find(message.sid(), guard);
+    if (session == nullptr)
     {
         Log::debug(std::format("session is not exist {}", message.sid()),
                    typeid(this).name());
+        return SendStatus::UnknownSession;
     }
+    return session->send(message.bodyView(), sendClass);
 }
-std::unique_ptr<Play::ClientMessage> WSStreamSocket::recv()
+size_t WSStreamSocket::broadcast(std::span<const int64_t> sids,
+                                 const SharedPayload &payload,
+                                 SendClass sendClass)
 {
-    std::unique_ptr<Play::ClientMessage> recvMessage;
-
-    if (_recvBuffer.try_pop(recvMessage))
+    size_t sent = 0;
+    auto guard = _sessions.pin();
+    for (int64_t sid : sids)
     {
-        return recvMessage;
+        WSSession *session = _sessions.find(sid, guard);
+        if (session != nullptr &&
+            session->send(payload, sendClass) == SendStatus::Queued)
+        {
+            sent++;
+        }
     }
-    return nullptr;
+    return sent;
+}
+std::unique_ptr<Play::ClientMessage> WSStreamSocket::recv()
+{
+    return _recvBuffer->tryPop();
+}
+size_t WSStreamSocket::recvBatch(
+    std::span<std::unique_ptr<ClientMessage>> messages,
+    size_t max)
+{
+    return _recvBuffer->popBatch(messages, max);
+}
+std::unique_ptr<Play::ClientMessage> WSStreamSocket::recvWait(
+    std::chrono::milliseconds timeout)
+{
+    return _recvBuffer->waitPop(timeout);
+}
+int WSStreamSocket::recvEventFd() const
+{
+    return _recvBuffer->eventFd();
 }
 
-void WSStreamSocket::addSession(int64_t sid, std::shared_ptr<WSSession> session)
+size_t WSStreamSocket::recvBatch(
+    size_t shard,
+    std::span<std::unique_ptr<ClientMessage>> messages,
+    size_t max)
 {
-    _sessions.insert(make_pair(sid, session));
+    return _recvBuffer->popBatch(shard, messages, max);
+}
+size_t WSStreamSocket::ioThreads() const
+{
+    return _recvBuffer->shardCount();
+}
+size_t WSStreamSocket::workers() const
+{
+    return _dispatcher != nullptr ? _dispatcher->workers() : 0;
+}
+ReceiveQueue &WSStreamSocket::workerMailbox(size_t worker)
+{
+    return _dispatcher->mailbox(worker);
+}
+
+int64_t WSStreamSocket::addSession(std::shared_ptr<WSSession> session)
+{
+    return _sessions.insert(std::move(session));
 }
 void WSStreamSocket::removeSession(int64_t sid)
 {
-    _sessions.erase(sid);
+    _sessions.remove(sid);
+}
+
+void WSStreamSocket::setIoConfig(const IoConfig &config)
+{
+    requireUnbound("setIoConfig");
+    _ioConfig = config;
+    createQueues();
+}
+void WSStreamSocket::setListenConfig(const ListenConfig &config)
+{
+    _listenConfig = config;
+}
+void WSStreamSocket::setStageDispatch(const StageDispatchConfig &config)
+{
+    requireUnbound("setStageDispatch");
+    _dispatchConfig = config;
+    createQueues();
+}
+void WSStreamSocket::requireUnbound(const char *setter) const
+{
+    // I/O threads push into the queues createQueues() would replace
+    if (_service != nullptr)
+    {
+        throw std::logic_error(
+            std::format("{} must be called before bind()", setter));
+    }
+}
+void WSStreamSocket::createQueues()
+{
+    size_t shards = static_cast<size_t>(std::max(_ioConfig.threads, 1));
+    _recvBuffer = std::make_unique<ReceiveQueue>(shards);
+    _dispatcher = _dispatchConfig.workers > 0
+                      ? std::make_unique<StageDispatcher>(_dispatchConfig,
+                                                          shards)
+                      : nullptr;
+}
+void WSStreamSocket::deliver(size_t shard,
+                             std::unique_ptr<ClientMessage> message)
+{
+    if (_dispatcher != nullptr)
+    {
+        _dispatcher->push(shard, std::move(message));
+    }
+    else
+    {
+        _recvBuffer->push(shard, std::move(message));
+    }
+}
+void WSStreamSocket::setBackpressurePolicy(
+    const SendBackpressurePolicy &policy)
+{
+    _backpressurePolicy = policy;
+}
+void WSStreamSocket::setSendCoalescingPolicy(
+    const SendCoalescingPolicy &policy)
+{
+    _sendPolicy = policy;
+}
+void WSStreamSocket::flushSends()
+{
+    int64_t sid = 0;
+    auto guard = _sessions.pin();
+    while (_stagedSessions.try_pop(sid))
+    {
+        if (WSSession *session = _sessions.find(sid, guard))
+        {
+            session->flushStaged();
+        }
+    }
+}
+void WSStreamSocket::setBufferReclaimPolicy(const BufferReclaimPolicy &policy)
+{
+    _reclaimPolicy = policy;
+}
+void WSStreamSocket::setIdlePolicy(const IdlePolicy &policy)
+{
+    _idle.setPolicy(policy);
+}
+void WSStreamSocket::checkIdleSessions()
+{
+    auto guard = _sessions.pin();
+    _idle.advance(std::chrono::steady_clock::now(),
+                  [this, &guard](int64_t sid) {
+                      return _sessions.find(sid, guard);
+                  });
+}
+void WSStreamSocket::reclaimIdleBuffers()
+{
+    auto now = std::chrono::steady_clock::now();
+    _sessions.forEach([now](int64_t, WSSession &session) {
+        session.reclaimBuffer(now);
+    });
+
+    auto pool = ParserBufferStats::pool();
+    Log::debug(std::format("parser buffers: sessions:{},bytes:{},"
+                           "pool:{},pool_free:{},pool_released:{}",
+                           ParserBufferStats::parsers(),
+                           ParserBufferStats::bytes(),
+                           pool.pooledBytes,
+                           pool.freeBytes,
+                           pool.releasedBytes),
+               typeid(this).name());
 }
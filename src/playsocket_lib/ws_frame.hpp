@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "bit_converter.hpp"
+
+namespace Play
+{
+
+// Header of an unmasked, final WebSocket frame as a server sends it
+// (RFC 6455 section 5.2), for writing frames without CppServer's per-send
+// framing buffer.
+class WSFrameHeader
+{
+public:
+    static constexpr size_t MAX_SIZE = 10;
+    static constexpr unsigned char OPCODE_BINARY = 0x02;
+
+    static WSFrameHeader binary(size_t payloadSize)
+    {
+        return WSFrameHeader(OPCODE_BINARY, payloadSize);
+    }
+
+    WSFrameHeader(unsigned char opcode, size_t payloadSize)
+    {
+        _bytes[0] = static_cast<unsigned char>(0x80 | opcode);
+        if (payloadSize < 126)
+        {
+            _bytes[1] = static_cast<unsigned char>(payloadSize);
+            _size = 2;
+        }
+        else if (payloadSize <= UINT16_MAX)
+        {
+            _bytes[1] = 126;
+            BitConverter::storeNetwork(&_bytes[2],
+                                       static_cast<uint16_t>(payloadSize));
+            _size = 4;
+        }
+        else
+        {
+            _bytes[1] = 127;
+            BitConverter::storeNetwork(&_bytes[2],
+                                       static_cast<uint64_t>(payloadSize));
+            _size = 10;
+        }
+    }
+
+    std::span<const unsigned char> bytes() const
+    {
+        return {_bytes.data(), _size};
+    }
+
+private:
+    std::array<unsigned char, MAX_SIZE> _bytes{};
+    size_t _size = 0;
+};
+
+} // namespace Play
@@ -1,8 +1,25 @@
 #pragma once
 
 #include "test_bit_converter.hpp"
+#include "test_buffer_pool.hpp"
+#include "test_client_message.hpp"
+#include "test_gateway.hpp"
+#include "test_header_codec.hpp"
+#include "test_idle_monitor.hpp"
+#include "test_outbound_queue.hpp"
+#include "test_receive_queue.hpp"
+#include "test_reply_encoder.hpp"
 #include "test_ring_buffer.hpp"
+#include "test_router_pump.hpp"
+#include "test_router_socket.hpp"
+#include "test_send_coalescer.hpp"
+#include "test_session_registry.hpp"
+#include "test_shared_payload.hpp"
+#include "test_stage_dispatcher.hpp"
 #include "test_stream_parser.hpp"
+#include "test_timer_wheel.hpp"
+#include "test_uring_stream_socket.hpp"
+#include "test_ws_frame.hpp"
 //#include <catch2/catch_test_macros.hpp>
 
 // #include "my_lib.h"
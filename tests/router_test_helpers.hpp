@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "router_socket.hpp"
+
+namespace RouterTest
+{
+
+inline Play::RouterMessage makeMessage(const std::string &target,
+                                       const std::string &body)
+{
+    return Play::RouterMessage(target,
+                               "h",
+                               zmq::message_t(body.data(), body.size()));
+}
+
+inline std::string text(zmq::message_t &message)
+{
+    return std::string(static_cast<const char *>(message.data()),
+                       message.size());
+}
+
+// router_mandatory rejects a peer until its connection is attached, so this
+// retries for up to five seconds
+inline void sendWhenConnected(Play::RouterSocket &socket,
+                              const std::string &target,
+                              const std::string &body)
+{
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (true)
+    {
+        Play::RouterMessage message = makeMessage(target, body);
+        try
+        {
+            if (socket.send(message))
+            {
+                return;
+            }
+        }
+        catch (zmq::error_t &)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                throw;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+// sends one message from `from` and waits for `to` to receive it, so both
+// ends know each other; nothing else is left queued on `to`
+inline void handshake(Play::RouterSocket &from,
+                      Play::RouterSocket &to,
+                      const std::string &target)
+{
+    sendWhenConnected(from, target, "hello");
+
+    Play::RouterMessageBatch batch(1);
+    if (to.recvBatch(batch, 1, std::chrono::seconds(5)) == 0)
+    {
+        throw std::runtime_error("router handshake timed out");
+    }
+}
+
+// discards whatever is still queued on `socket`
+inline void drain(Play::RouterSocket &socket)
+{
+    Play::RouterMessageBatch batch(16);
+    while (socket.recvBatch(batch,
+                            batch.capacity(),
+                            std::chrono::milliseconds(10)) > 0)
+    {
+    }
+}
+
+} // namespace RouterTest
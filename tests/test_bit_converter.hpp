@@ -58,4 +58,29 @@ TEST_CASE("BitConverter toNetwork and toHost", "[BitConverter]")
         REQUIRE(networkValue == -648518346341351425);
         REQUIRE(hostValue == value);
     }
+
+    SECTION("byteswap")
+    {
+        REQUIRE(BitConverter::byteswap(static_cast<uint16_t>(0x1234)) ==
+                0x3412);
+        REQUIRE(BitConverter::byteswap(static_cast<uint32_t>(0x12345678)) ==
+                0x78563412);
+        REQUIRE(BitConverter::byteswap(static_cast<int8_t>(-3)) == -3);
+        static_assert(BitConverter::byteswap(static_cast<uint16_t>(0x0102)) ==
+                      0x0201);
+    }
+
+    SECTION("Unaligned network order load and store")
+    {
+        unsigned char bytes[7] = {};
+        BitConverter::storeNetwork<int32_t>(bytes + 1, 0x12345678);
+        REQUIRE(bytes[1] == 0x12);
+        REQUIRE(bytes[4] == 0x78);
+        REQUIRE(BitConverter::loadNetwork<int32_t>(bytes + 1) == 0x12345678);
+
+        BitConverter::storeNetwork<int16_t>(bytes + 5, -2);
+        REQUIRE(bytes[5] == 0xFF);
+        REQUIRE(bytes[6] == 0xFE);
+        REQUIRE(BitConverter::loadNetwork<int16_t>(bytes + 5) == -2);
+    }
 }
@@ -0,0 +1,192 @@
+#pragma once
+#include "buffer_pool.hpp"
+#include "ring_buffer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstring>
+#include <optional>
+#include <thread>
+
+using namespace Play;
+
+namespace BufferPoolTest
+{
+
+// a thread_local that outlives the thread's BufferPool cache, the way a
+// static object outlives the main thread's
+struct LateRelease
+{
+    std::optional<PooledStorage> storage;
+    std::atomic<int> *released = nullptr;
+
+    ~LateRelease()
+    {
+        storage.reset();
+        PooledStorage late(BufferPool::MIN_BLOCK_SIZE);
+        late[0] = 1;
+        released->fetch_add(1);
+    }
+};
+
+} // namespace BufferPoolTest
+
+TEST_CASE("BufferPool functionality", "[BufferPool]")
+{
+    auto &pool = BufferPool::instance();
+
+    SECTION("Size classes")
+    {
+        REQUIRE(BufferPool::isPooledSize(1024 * 8));
+        REQUIRE(BufferPool::isPooledSize(1024 * 64));
+        REQUIRE(BufferPool::isPooledSize(1024 * 512));
+        REQUIRE_FALSE(BufferPool::isPooledSize(1024 * 4));
+        REQUIRE_FALSE(BufferPool::isPooledSize(1024 * 1024));
+        REQUIRE_FALSE(BufferPool::isPooledSize(1024 * 8 + 1));
+    }
+
+    SECTION("Steady state reuses blocks without system allocations")
+    {
+        // warm the class up so the thread cache holds blocks
+        pool.deallocate(pool.allocate(1024 * 16), 1024 * 16);
+        auto before = pool.stats();
+
+        for (int i = 0; i < 1000; i++)
+        {
+            unsigned char *block = pool.allocate(1024 * 16);
+            block[0] = static_cast<unsigned char>(i);
+            block[1024 * 16 - 1] = static_cast<unsigned char>(i);
+            pool.deallocate(block, 1024 * 16);
+        }
+
+        auto after = pool.stats();
+        REQUIRE(after.slabAllocations == before.slabAllocations);
+        REQUIRE(after.unpooledAllocations == before.unpooledAllocations);
+        REQUIRE(after.threadCacheHits - before.threadCacheHits == 1000);
+        REQUIRE(after.allocations - before.allocations == 1000);
+        REQUIRE(after.deallocations - before.deallocations == 1000);
+    }
+
+    SECTION("Blocks of one class do not overlap")
+    {
+        std::vector<unsigned char *> blocks;
+        for (size_t i = 0; i < 100; i++)
+        {
+            blocks.push_back(pool.allocate(1024 * 8));
+            std::memset(blocks.back(), static_cast<int>(i), 1024 * 8);
+        }
+        for (size_t i = 0; i < 100; i++)
+        {
+            REQUIRE(blocks[i][0] == static_cast<unsigned char>(i));
+            REQUIRE(blocks[i][1024 * 8 - 1] == static_cast<unsigned char>(i));
+            pool.deallocate(blocks[i], 1024 * 8);
+        }
+    }
+
+    SECTION("Blocks cached by an exiting thread go back to the depot")
+    {
+        std::thread([&pool]() {
+            for (int i = 0; i < 8; i++)
+            {
+                pool.deallocate(pool.allocate(1024 * 256), 1024 * 256);
+            }
+        }).join();
+
+        auto before = pool.stats();
+        std::thread([&pool]() {
+            pool.deallocate(pool.allocate(1024 * 256), 1024 * 256);
+        }).join();
+        auto after = pool.stats();
+
+        REQUIRE(after.slabAllocations == before.slabAllocations);
+        REQUIRE(after.depotHits - before.depotHits == 1);
+    }
+
+    SECTION("Blocks released after the thread cache is gone use the depot")
+    {
+        std::atomic<int> released{0};
+        auto before = pool.stats();
+        std::thread([&released]() {
+            // constructed before the pool's cache, so destroyed after it
+            thread_local BufferPoolTest::LateRelease holder;
+            holder.released = &released;
+            holder.storage.emplace(BufferPool::MIN_BLOCK_SIZE);
+        }).join();
+        auto after = pool.stats();
+
+        REQUIRE(released == 1);
+        REQUIRE(after.allocations - before.allocations == 2);
+        REQUIRE(after.deallocations - before.deallocations == 2);
+    }
+
+    SECTION("Depots release free blocks above their limit")
+    {
+        constexpr size_t size = BufferPool::MAX_BLOCK_SIZE;
+        constexpr size_t count = 16;
+        size_t limit = pool.depotLimit();
+        pool.setDepotLimit(BufferPool::SLAB_SIZE);
+
+        auto cycle = [&pool]() {
+            std::thread([&pool]() {
+                std::vector<unsigned char *> blocks;
+                for (size_t i = 0; i < count; i++)
+                {
+                    blocks.push_back(pool.allocate(size));
+                    std::memset(blocks.back(), 0x5A, size);
+                }
+                for (unsigned char *block : blocks)
+                {
+                    pool.deallocate(block, size);
+                }
+            }).join();
+        };
+
+        cycle();
+        auto trimmed = pool.stats();
+        REQUIRE(trimmed.releasedBytes >= count * size - BufferPool::SLAB_SIZE);
+        REQUIRE(trimmed.freeBytes + trimmed.releasedBytes <=
+                trimmed.pooledBytes);
+
+        // released blocks are handed out again before any new slab
+        cycle();
+        auto reused = pool.stats();
+        REQUIRE(reused.slabAllocations == trimmed.slabAllocations);
+        REQUIRE(reused.pooledBytes == trimmed.pooledBytes);
+
+        pool.setDepotLimit(limit);
+    }
+
+    SECTION("Unpooled sizes fall back to the heap")
+    {
+        auto before = pool.stats();
+        pool.deallocate(pool.allocate(100), 100);
+        auto after = pool.stats();
+        REQUIRE(after.unpooledAllocations - before.unpooledAllocations == 1);
+    }
+
+    SECTION("Ring buffer growth draws from the pool")
+    {
+        {
+            PowerOfTwoRingBuffer warm(1024 * 8, 1024 * 64);
+            warm.resizeBuffer(1024 * 16);
+            warm.resizeBuffer(1024 * 32);
+            warm.resizeBuffer(1024 * 64);
+        }
+
+        auto before = pool.stats();
+        {
+            PowerOfTwoRingBuffer buf(1024 * 8, 1024 * 64);
+            std::vector<unsigned char> data(1024 * 40, 0x5A);
+            buf.write(data.data(), 0, data.size());
+            REQUIRE(buf.capacity() == 1024 * 64);
+
+            std::vector<unsigned char> out(data.size());
+            buf.read(out.data(), 0, out.size());
+            REQUIRE(out == data);
+        }
+        auto after = pool.stats();
+
+        REQUIRE(after.slabAllocations == before.slabAllocations);
+        REQUIRE(after.allocations - before.allocations ==
+                after.deallocations - before.deallocations);
+    }
+}
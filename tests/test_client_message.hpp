@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+#include "client_message.hpp"
+#include "object_pool.hpp"
+
+using namespace Play;
+
+TEST_CASE("ClientMessage body storage", "[ClientMessage]")
+{
+    Header header(1, 2, 3, 4);
+
+    SECTION("Small bodies are stored inline")
+    {
+        std::vector<unsigned char> data(ClientMessage::INLINE_BODY_CAPACITY,
+                                        0x42);
+        auto message = std::make_unique<ClientMessage>(
+            7, header, data.data(), data.size());
+
+        REQUIRE(message->hasInlineBody());
+        REQUIRE(message->bodyView().size() == data.size());
+        REQUIRE(message->bodyView()[0] == 0x42);
+
+        auto body = message->body();
+        REQUIRE(body->size() == data.size());
+        REQUIRE(static_cast<unsigned char *>(body->data())[63] == 0x42);
+        REQUIRE_FALSE(message->hasInlineBody());
+    }
+
+    SECTION("Empty bodies still yield a message")
+    {
+        auto message = std::make_unique<ClientMessage>(7, header, nullptr, 0);
+        REQUIRE(message->hasInlineBody());
+        REQUIRE(message->bodyView().empty());
+        REQUIRE(message->body()->size() == 0);
+    }
+
+    SECTION("Large bodies keep a zmq message")
+    {
+        std::vector<unsigned char> data(
+            ClientMessage::INLINE_BODY_CAPACITY + 1, 0x24);
+        auto message = std::make_unique<ClientMessage>(
+            7, header, data.data(), data.size());
+
+        REQUIRE_FALSE(message->hasInlineBody());
+        const void *bytes = message->bodyView().data();
+
+        // taking the body hands over the same bytes without a copy
+        auto body = message->body();
+        REQUIRE(body->data() == bytes);
+        REQUIRE(body->size() == data.size());
+        REQUIRE(message->bodyView().empty());
+    }
+
+    SECTION("Control messages have no body")
+    {
+        auto message = std::make_unique<ClientMessage>(7, CONNECT);
+        REQUIRE_FALSE(message->hasInlineBody());
+        REQUIRE(message->bodyView().empty());
+        REQUIRE(message->body() == nullptr);
+    }
+
+    SECTION("Freed messages are reused")
+    {
+        auto first = std::make_unique<ClientMessage>(7, CONNECT);
+        const void *address = first.get();
+        first.reset();
+
+        auto second = std::make_unique<ClientMessage>(8, DISCONNECT);
+        REQUIRE(static_cast<const void *>(second.get()) == address);
+    }
+}
+
+TEST_CASE("ObjectPool concurrent use", "[ObjectPool]")
+{
+    ObjectPool<48, 8> pool;
+    const int threads = 4;
+    const int rounds = 2000;
+    const int held = 300;
+
+    std::atomic<bool> shared{false};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&pool, &shared, t]() {
+            std::vector<int *> slots;
+            for (int round = 0; round < rounds; round++)
+            {
+                for (int i = 0; i < held; i++)
+                {
+                    auto *value = static_cast<int *>(pool.allocate());
+                    *value = t * rounds + round;
+                    slots.push_back(value);
+                }
+                for (int *value : slots)
+                {
+                    // a slot handed to two owners would be overwritten
+                    if (*value != t * rounds + round)
+                    {
+                        shared = true;
+                    }
+                    pool.deallocate(value);
+                }
+                slots.clear();
+            }
+        });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    REQUIRE_FALSE(shared);
+    // slots are recycled, so the pool never grows past the peak in use
+    REQUIRE(pool.capacity() >= held);
+    REQUIRE(pool.capacity() <= 2 * ObjectPool<48, 8>::SLAB_SLOTS);
+    REQUIRE(pool.heapSlots() == 0);
+}
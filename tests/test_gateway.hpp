@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <deque>
+#include <vector>
+
+#include "gateway.hpp"
+#include "router_test_helpers.hpp"
+
+using namespace Play;
+
+namespace GatewayTest
+{
+
+struct FakeClients
+{
+    std::deque<std::unique_ptr<ClientMessage>> inbound;
+    std::vector<std::unique_ptr<ClientMessage>> sent;
+
+    size_t recvBatch(std::span<std::unique_ptr<ClientMessage>> messages,
+                     size_t max)
+    {
+        size_t count = 0;
+        while (count < max && count < messages.size() && !inbound.empty())
+        {
+            messages[count++] = std::move(inbound.front());
+            inbound.pop_front();
+        }
+        return count;
+    }
+
+    SendStatus send(ClientMessage &&message)
+    {
+        sent.push_back(std::make_unique<ClientMessage>(std::move(message)));
+        return SendStatus::Queued;
+    }
+
+    int recvEventFd() const
+    {
+        return -1;
+    }
+};
+
+struct FakeBackends
+{
+    std::vector<RouterMessage> sent;
+    // identities that are not connected
+    std::vector<std::string> offline;
+
+    bool send(RouterMessage &message)
+    {
+        std::string target = RouterTest::text(message.target());
+        if (std::find(offline.begin(), offline.end(), target) != offline.end())
+        {
+            return false;
+        }
+        sent.push_back(std::move(message));
+        return true;
+    }
+
+    size_t recvBatch(RouterMessageBatch &batch,
+                     size_t max,
+                     std::chrono::milliseconds timeout)
+    {
+        batch.clear();
+        return 0;
+    }
+
+    void *handle()
+    {
+        return nullptr;
+    }
+};
+
+} // namespace GatewayTest
+
+TEST_CASE("Gateway functionality", "[Gateway]")
+{
+    using namespace GatewayTest;
+    using RouterTest::text;
+
+    auto clients = std::make_shared<FakeClients>();
+    FakeBackends backends;
+    GatewayConfig config;
+    config.routes = {{1, "lobby"}, {2, "game"}, {3, "game"}};
+    Gateway<FakeClients, FakeBackends> gateway(clients, backends, config);
+
+    SECTION("Envelopes survive a round trip")
+    {
+        GatewayEnvelope envelope;
+        envelope.sid = 0x0102030405060708;
+        envelope.type = MessageType::DISCONNECT;
+        envelope.header.service_id = 2;
+        envelope.header.msg_id = -7;
+        envelope.header.msg_seq = 300;
+        envelope.header.error_code = -2;
+        envelope.header.stage_index = 4;
+
+        zmq::message_t frame = envelope.encode();
+        REQUIRE(frame.size() == GatewayEnvelope::SIZE);
+
+        GatewayEnvelope decoded = GatewayEnvelope::decode(frame);
+        REQUIRE(decoded.sid == envelope.sid);
+        REQUIRE(decoded.type == envelope.type);
+        REQUIRE(decoded.header.service_id == 2);
+        REQUIRE(decoded.header.msg_id == -7);
+        REQUIRE(decoded.header.msg_seq == 300);
+        REQUIRE(decoded.header.error_code == -2);
+        REQUIRE(decoded.header.stage_index == 4);
+
+        REQUIRE_THROWS_AS(GatewayEnvelope::decode(zmq::message_t(3)),
+                          std::invalid_argument);
+    }
+
+    SECTION("Bodies go to the backend of their service without a copy")
+    {
+        auto body = std::make_unique<zmq::message_t>(256);
+        const void *data = body->data();
+        clients->inbound.push_back(std::make_unique<ClientMessage>(
+            9, Header(2, 11, 1, 0), std::move(body)));
+
+        REQUIRE(gateway.forward() == 1);
+        REQUIRE(backends.sent.size() == 1);
+
+        RouterMessage &message = backends.sent[0];
+        REQUIRE(text(message.target()) == "game");
+        REQUIRE(message.body().data() == data);
+        REQUIRE(message.body().size() == 256);
+
+        GatewayEnvelope envelope = GatewayEnvelope::decode(message.Header());
+        REQUIRE(envelope.sid == 9);
+        REQUIRE(envelope.type == MessageType::NORMAL);
+        REQUIRE(envelope.header.msg_id == 11);
+    }
+
+    SECTION("Unknown services are dropped")
+    {
+        const unsigned char body[] = {1, 2, 3};
+        int64_t before = GatewayStats::unroutable();
+        clients->inbound.push_back(std::make_unique<ClientMessage>(
+            9, Header(5, 11, 1, 0), body, sizeof(body)));
+
+        REQUIRE(gateway.forward() == 0);
+        REQUIRE(backends.sent.empty());
+        REQUIRE(GatewayStats::unroutable() == before + 1);
+    }
+
+    SECTION("Session events reach every backend once")
+    {
+        clients->inbound.push_back(
+            std::make_unique<ClientMessage>(9, MessageType::CONNECT));
+
+        REQUIRE(gateway.forward() == 2);
+        REQUIRE(backends.sent.size() == 2);
+        std::vector<std::string> targets;
+        for (RouterMessage &message : backends.sent)
+        {
+            targets.push_back(text(message.target()));
+            REQUIRE(GatewayEnvelope::decode(message.Header()).type ==
+                    MessageType::CONNECT);
+        }
+        std::sort(targets.begin(), targets.end());
+        REQUIRE(targets == std::vector<std::string>{"game", "lobby"});
+    }
+
+    SECTION("Session events only count the backends that got them")
+    {
+        backends.offline.push_back("lobby");
+        clients->inbound.push_back(
+            std::make_unique<ClientMessage>(9, MessageType::DISCONNECT));
+
+        REQUIRE(gateway.forward() == 1);
+        REQUIRE(backends.sent.size() == 1);
+        REQUIRE(text(backends.sent[0].target()) == "game");
+    }
+
+    SECTION("Replies go back to the envelope's session")
+    {
+        GatewayEnvelope envelope;
+        envelope.sid = 42;
+        envelope.header.service_id = 2;
+
+        zmq::message_t frame(128);
+        const void *data = frame.data();
+        RouterMessage reply(zmq::message_t(),
+                            envelope.encode(),
+                            std::move(frame));
+
+        REQUIRE(gateway.returnToClient(reply));
+        REQUIRE(clients->sent.size() == 1);
+        REQUIRE(clients->sent[0]->sid() == 42);
+        REQUIRE(clients->sent[0]->bodyView().data() == data);
+
+        RouterMessage malformed(zmq::message_t(),
+                                zmq::message_t(2),
+                                zmq::message_t(1));
+        REQUIRE_FALSE(gateway.returnToClient(malformed));
+    }
+}
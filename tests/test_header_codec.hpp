@@ -0,0 +1,68 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+
+#include "header_codec.hpp"
+
+using namespace Play;
+
+TEST_CASE("HeaderCodec client layout", "[HeaderCodec]")
+{
+    REQUIRE(ClientHeaderCodec::SIZE == 11);
+
+    SECTION("Encodes fields big-endian in wire order")
+    {
+        unsigned char frame[ClientHeaderCodec::SIZE] = {};
+        ClientHeaderCodec::encode(frame,
+                                  0x0102,
+                                  Header(0x0304, 0x05060708, 0x090A, 0x0B));
+
+        const unsigned char expected[] = {
+            0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B};
+        REQUIRE(std::memcmp(frame, expected, sizeof(expected)) == 0);
+    }
+
+    SECTION("Decodes from an unaligned address")
+    {
+        unsigned char storage[ClientHeaderCodec::SIZE + 1] = {};
+        unsigned char *frame = storage + 1;
+        ClientHeaderCodec::encode(frame, 513, Header(-2, -300000, -4, -5));
+
+        REQUIRE(ClientHeaderCodec::peekBodySize(frame) == 513);
+        Header header = ClientHeaderCodec::decode(frame);
+        REQUIRE(header.service_id == -2);
+        REQUIRE(header.msg_id == -300000);
+        REQUIRE(header.msg_seq == -4);
+        REQUIRE(header.stage_index == -5);
+    }
+}
+
+TEST_CASE("HeaderCodec reply layout", "[HeaderCodec]")
+{
+    REQUIRE(ReplyHeaderCodec::SIZE == 13);
+
+    ReplyHeader header;
+    header.service_id = 0x0304;
+    header.msg_id = 0x05060708;
+    header.msg_seq = 0x090A;
+    header.error_code = 0x0B0C;
+    header.stage_index = 0x0D;
+
+    unsigned char frame[ReplyHeaderCodec::SIZE] = {};
+    ReplyHeaderCodec::encode(frame, 0x0102, header);
+
+    // the error code sits between msg_seq and stage_index
+    const unsigned char expected[] = {0x01, 0x02, 0x03, 0x04, 0x05,
+                                      0x06, 0x07, 0x08, 0x09, 0x0A,
+                                      0x0B, 0x0C, 0x0D};
+    REQUIRE(std::memcmp(frame, expected, sizeof(expected)) == 0);
+
+    ReplyHeader decoded = ReplyHeaderCodec::decode(frame);
+    REQUIRE(ReplyHeaderCodec::peekBodySize(frame) == 0x0102);
+    REQUIRE(decoded.service_id == header.service_id);
+    REQUIRE(decoded.msg_id == header.msg_id);
+    REQUIRE(decoded.msg_seq == header.msg_seq);
+    REQUIRE(decoded.error_code == header.error_code);
+    REQUIRE(decoded.stage_index == header.stage_index);
+}
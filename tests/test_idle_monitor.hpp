@@ -0,0 +1,129 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <map>
+
+#include "idle_monitor.hpp"
+
+using namespace Play;
+
+namespace IdleMonitorTest
+{
+
+struct FakeSession
+{
+    SessionActivity state;
+    int disconnects = 0;
+    int heartbeats = 0;
+
+    SessionActivity &activity()
+    {
+        return state;
+    }
+
+    bool Disconnect()
+    {
+        disconnects++;
+        return true;
+    }
+
+    SendStatus send(const SharedPayload &payload, SendClass)
+    {
+        REQUIRE(payload.size() == 2);
+        heartbeats++;
+        return SendStatus::Queued;
+    }
+};
+
+} // namespace IdleMonitorTest
+
+TEST_CASE("IdleMonitor functionality", "[IdleMonitor]")
+{
+    using IdleMonitorTest::FakeSession;
+    using std::chrono::milliseconds;
+
+    IdlePolicy policy;
+    policy.tick = milliseconds(100);
+    policy.heartbeat = {0xBE, 0xA7};
+
+    std::map<int64_t, FakeSession> sessions;
+    auto find = [&sessions](int64_t sid) -> FakeSession * {
+        auto it = sessions.find(sid);
+        return it == sessions.end() ? nullptr : &it->second;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    // half a tick late, so each call lands on tick ms / 100
+    auto at = [start](int ms) { return start + milliseconds(ms + 50); };
+
+    SECTION("Nothing is tracked while disabled")
+    {
+        IdleMonitor<FakeSession> monitor(policy);
+        REQUIRE_FALSE(monitor.enabled());
+        monitor.track(1, sessions[1].state);
+        REQUIRE(monitor.tracked() == 0);
+    }
+
+    SECTION("A tick of zero is rejected")
+    {
+        IdleMonitor<FakeSession> monitor(policy);
+        policy.tick = milliseconds(0);
+        REQUIRE_THROWS_AS(monitor.setPolicy(policy), std::invalid_argument);
+        REQUIRE_THROWS_AS(IdleMonitor<FakeSession>(policy),
+                          std::invalid_argument);
+    }
+
+    SECTION("Silent sessions are disconnected, active ones are not")
+    {
+        policy.idleTimeout = milliseconds(1000);
+        IdleMonitor<FakeSession> monitor(policy);
+        REQUIRE(monitor.enabled());
+
+        monitor.track(1, sessions[1].state);
+        monitor.track(2, sessions[2].state);
+
+        for (int ms = 100; ms <= 3000; ms += 100)
+        {
+            monitor.advance(at(ms), find);
+            // session 2 keeps receiving
+            sessions[2].state.received.store(monitor.now());
+        }
+
+        REQUIRE(sessions[1].disconnects == 1);
+        REQUIRE(sessions[2].disconnects == 0);
+        // session 1 left the wheel once it was disconnected
+        REQUIRE(monitor.tracked() == 1);
+    }
+
+    SECTION("Heartbeats go to sessions the server is quiet towards")
+    {
+        policy.heartbeatInterval = milliseconds(500);
+        IdleMonitor<FakeSession> monitor(policy);
+
+        monitor.track(1, sessions[1].state);
+        monitor.track(2, sessions[2].state);
+
+        for (int ms = 100; ms <= 2000; ms += 100)
+        {
+            monitor.advance(at(ms), find);
+            sessions[2].state.sent.store(monitor.now());
+        }
+
+        REQUIRE(sessions[1].heartbeats == 4);
+        REQUIRE(sessions[2].heartbeats == 0);
+        REQUIRE(sessions[1].disconnects == 0);
+    }
+
+    SECTION("Sessions that are gone are dropped from the wheel")
+    {
+        policy.idleTimeout = milliseconds(300);
+        IdleMonitor<FakeSession> monitor(policy);
+
+        monitor.track(1, sessions[1].state);
+        sessions.erase(1);
+        monitor.advance(at(1000), find);
+
+        REQUIRE(monitor.tracked() == 0);
+    }
+}
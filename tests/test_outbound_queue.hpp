@@ -0,0 +1,139 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "outbound_queue.hpp"
+
+using namespace Play;
+
+TEST_CASE("OutboundQueue functionality", "[OutboundQueue]")
+{
+    OutboundQueue queue;
+    SendBackpressurePolicy policy;
+    policy.highWatermark = 100;
+    policy.lowWatermark = 20;
+
+    // what the socket has been given, by message tag
+    std::vector<unsigned char> written;
+    auto send = [&](unsigned char tag,
+                    size_t size,
+                    size_t pending,
+                    SendClass sendClass = SendClass::Normal) {
+        std::vector<unsigned char> data(size, tag);
+        return queue.submit(
+            size,
+            sendClass,
+            pending,
+            policy,
+            [&written, tag]() { written.push_back(tag); },
+            [&data]() { return SharedPayload(data); });
+    };
+    auto release = [&](size_t pending) {
+        return queue.release(pending,
+                             policy,
+                             [&written](const SharedPayload &p) {
+                                 written.push_back(p.bytes()[0]);
+                             });
+    };
+
+    SECTION("No limit writes everything")
+    {
+        policy.highWatermark = 0;
+        REQUIRE(send(1, 10, 1000000) == SendStatus::Queued);
+        REQUIRE(written == std::vector<unsigned char>{1});
+    }
+
+    SECTION("Drop newest throttles between the watermarks")
+    {
+        policy.action = BackpressureAction::DropNewest;
+        int64_t dropped = OutboundStats::droppedMessages();
+
+        REQUIRE(send(1, 10, 80) == SendStatus::Queued);
+        REQUIRE(send(2, 30, 80) == SendStatus::Dropped);
+        // still throttled although this one would fit
+        REQUIRE(send(3, 10, 50) == SendStatus::Dropped);
+
+        release(50);
+        REQUIRE(queue.throttled());
+        release(20);
+        REQUIRE_FALSE(queue.throttled());
+        REQUIRE(send(4, 10, 20) == SendStatus::Queued);
+
+        REQUIRE(written == std::vector<unsigned char>{1, 4});
+        REQUIRE(OutboundStats::droppedMessages() - dropped == 2);
+    }
+
+    SECTION("Disconnect policy reports the slow session")
+    {
+        policy.action = BackpressureAction::Disconnect;
+        int64_t disconnects = OutboundStats::disconnects();
+        REQUIRE(send(1, 50, 60) == SendStatus::Disconnected);
+        REQUIRE(OutboundStats::disconnects() - disconnects == 1);
+        REQUIRE(written.empty());
+    }
+
+    SECTION("Drop oldest holds messages and evicts droppable ones first")
+    {
+        policy.action = BackpressureAction::DropOldest;
+        int64_t held = OutboundStats::heldBytes();
+
+        REQUIRE(send(1, 30, 80, SendClass::Droppable) == SendStatus::Queued);
+        REQUIRE(queue.throttled());
+        REQUIRE(send(2, 30, 90) == SendStatus::Queued);
+        REQUIRE(send(3, 30, 90, SendClass::Droppable) == SendStatus::Queued);
+        REQUIRE(queue.heldBytes() == 90);
+        REQUIRE(OutboundStats::heldBytes() - held == 90);
+
+        // evicts 1, the oldest droppable held message, to make room
+        REQUIRE(send(4, 25, 90, SendClass::Droppable) == SendStatus::Queued);
+        REQUIRE(queue.heldBytes() == 85);
+
+        // evicts 3 and then 4; a normal message is never evicted
+        REQUIRE(send(5, 60, 90) == SendStatus::Queued);
+        REQUIRE(queue.heldBytes() == 90);
+        REQUIRE(send(6, 20, 90, SendClass::Droppable) == SendStatus::Dropped);
+        REQUIRE(send(7, 20, 90) == SendStatus::Disconnected);
+
+        release(10);
+        REQUIRE_FALSE(queue.throttled());
+        REQUIRE(written == std::vector<unsigned char>{2, 5});
+        REQUIRE(OutboundStats::heldBytes() == held);
+    }
+
+    SECTION("Released messages count against the next submit")
+    {
+        policy.action = BackpressureAction::DropOldest;
+        send(1, 30, 80);
+        send(2, 60, 90);
+        REQUIRE(queue.heldBytes() == 90);
+
+        // the socket drained to 10, then took the 90 released bytes
+        size_t released = release(10);
+        REQUIRE(released == 90);
+        REQUIRE(send(3, 20, 10 + released) == SendStatus::Queued);
+        REQUIRE(queue.throttled());
+        REQUIRE(queue.heldBytes() == 20);
+        REQUIRE(written == std::vector<unsigned char>{1, 2});
+    }
+
+    SECTION("A message over the whole budget goes out when nothing waits")
+    {
+        REQUIRE(send(1, 500, 0) == SendStatus::Queued);
+        REQUIRE(written == std::vector<unsigned char>{1});
+    }
+
+    SECTION("Clearing forgets held messages")
+    {
+        policy.action = BackpressureAction::DropOldest;
+        int64_t held = OutboundStats::heldBytes();
+        send(1, 50, 90);
+        send(2, 5, 90);
+        REQUIRE(OutboundStats::heldBytes() - held == 55);
+
+        queue.clear();
+        REQUIRE(OutboundStats::heldBytes() == held);
+        release(0);
+        REQUIRE(written.empty());
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+
+#include "receive_queue.hpp"
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
+
+using namespace Play;
+
+TEST_CASE("ReceiveQueue functionality", "[ReceiveQueue]")
+{
+    ReceiveQueue queue;
+
+    SECTION("Batch drain")
+    {
+        for (int64_t sid = 0; sid < 10; sid++)
+        {
+            queue.push(std::make_unique<ClientMessage>(sid, CONNECT));
+        }
+
+        std::array<std::unique_ptr<ClientMessage>, 4> batch;
+        REQUIRE(queue.popBatch(batch, batch.size()) == 4);
+        REQUIRE(batch[0]->sid() == 0);
+        REQUIRE(batch[3]->sid() == 3);
+
+        REQUIRE(queue.popBatch(batch, 2) == 2);
+        REQUIRE(batch[1]->sid() == 5);
+
+        REQUIRE(queue.popBatch(batch, batch.size()) == 4);
+        REQUIRE(queue.popBatch(batch, batch.size()) == 0);
+        REQUIRE(queue.tryPop() == nullptr);
+    }
+
+    SECTION("Wait times out on an empty queue")
+    {
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE(queue.waitPop(std::chrono::milliseconds(20)) == nullptr);
+        REQUIRE(std::chrono::steady_clock::now() - start >=
+                std::chrono::milliseconds(20));
+    }
+
+    SECTION("Wait wakes up when a producer pushes")
+    {
+        std::thread producer([&queue]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            queue.push(std::make_unique<ClientMessage>(42, CONNECT));
+        });
+
+        auto message = queue.waitPop(std::chrono::seconds(5));
+        producer.join();
+        REQUIRE(message != nullptr);
+        REQUIRE(message->sid() == 42);
+    }
+
+    SECTION("Every pushed message is received once")
+    {
+        const int64_t count = 20000;
+        std::thread producer([&queue]() {
+            for (int64_t sid = 0; sid < count; sid++)
+            {
+                queue.push(std::make_unique<ClientMessage>(sid, NORMAL));
+            }
+        });
+
+        int64_t expected = 0;
+        while (expected < count)
+        {
+            auto message = queue.waitPop(std::chrono::seconds(5));
+            REQUIRE(message != nullptr);
+            REQUIRE(message->sid() == expected);
+            expected++;
+        }
+        producer.join();
+        REQUIRE(queue.tryPop() == nullptr);
+    }
+
+#if defined(__linux__)
+    SECTION("Event descriptor follows the empty to non-empty transition")
+    {
+        pollfd descriptor{queue.eventFd(), POLLIN, 0};
+        REQUIRE(::poll(&descriptor, 1, 0) == 0);
+
+        queue.push(std::make_unique<ClientMessage>(1, CONNECT));
+        queue.push(std::make_unique<ClientMessage>(2, CONNECT));
+        REQUIRE(::poll(&descriptor, 1, 0) == 1);
+
+        // popping resets the descriptor
+        std::array<std::unique_ptr<ClientMessage>, 4> batch;
+        REQUIRE(queue.popBatch(batch, batch.size()) == 2);
+        REQUIRE(::poll(&descriptor, 1, 0) == 0);
+
+        queue.push(std::make_unique<ClientMessage>(3, CONNECT));
+        REQUIRE(::poll(&descriptor, 1, 0) == 1);
+    }
+#endif
+}
+
+TEST_CASE("ReceiveQueue shards", "[ReceiveQueue]")
+{
+    ReceiveQueue queue(4);
+    REQUIRE(queue.shardCount() == 4);
+
+    SECTION("Merged drain visits every shard")
+    {
+        for (int64_t sid = 0; sid < 8; sid++)
+        {
+            queue.push(static_cast<size_t>(sid % 4),
+                       std::make_unique<ClientMessage>(sid, CONNECT));
+        }
+
+        std::array<std::unique_ptr<ClientMessage>, 16> batch;
+        REQUIRE(queue.popBatch(batch, batch.size()) == 8);
+        int64_t sum = 0;
+        for (size_t i = 0; i < 8; i++)
+        {
+            sum += batch[i]->sid();
+        }
+        REQUIRE(sum == 28);
+        REQUIRE(queue.tryPop() == nullptr);
+    }
+
+    SECTION("A shard can be drained on its own")
+    {
+        queue.push(1, std::make_unique<ClientMessage>(10, CONNECT));
+        queue.push(2, std::make_unique<ClientMessage>(20, CONNECT));
+
+        std::array<std::unique_ptr<ClientMessage>, 4> batch;
+        REQUIRE(queue.popBatch(0, batch, batch.size()) == 0);
+        REQUIRE(queue.popBatch(2, batch, batch.size()) == 1);
+        REQUIRE(batch[0]->sid() == 20);
+        REQUIRE(queue.tryPop()->sid() == 10);
+    }
+
+    SECTION("Producers on separate shards keep their own order")
+    {
+        const int64_t perProducer = 10000;
+        std::vector<std::thread> producers;
+        for (size_t shard = 0; shard < 4; shard++)
+        {
+            producers.emplace_back([&queue, shard, perProducer]() {
+                for (int64_t i = 0; i < perProducer; i++)
+                {
+                    int64_t sid = static_cast<int64_t>(shard) << 32 | i;
+                    queue.push(shard,
+                               std::make_unique<ClientMessage>(sid, NORMAL));
+                }
+            });
+        }
+
+        std::array<int64_t, 4> next{};
+        for (int64_t received = 0; received < 4 * perProducer; received++)
+        {
+            auto message = queue.waitPop(std::chrono::seconds(5));
+            REQUIRE(message != nullptr);
+            size_t shard = static_cast<size_t>(message->sid() >> 32);
+            REQUIRE((message->sid() & 0xFFFFFFFF) == next[shard]);
+            next[shard]++;
+        }
+        for (auto &producer : producers)
+        {
+            producer.join();
+        }
+        REQUIRE(queue.tryPop() == nullptr);
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+#include "reply_encoder.hpp"
+
+using namespace Play;
+
+TEST_CASE("ReplyEncoder functionality", "[ReplyEncoder]")
+{
+    ReplyHeader header;
+    header.service_id = 7;
+    header.msg_id = 0x01020304;
+    header.msg_seq = 9;
+    header.error_code = -2;
+    header.stage_index = 3;
+
+    std::vector<unsigned char> body(300);
+    for (size_t i = 0; i < body.size(); i++)
+    {
+        body[i] = static_cast<unsigned char>(i);
+    }
+
+    auto checkFrame = [&header](const zmq::message_t &message,
+                                const std::vector<unsigned char> &body) {
+        REQUIRE(message.size() == ReplyEncoder::HEADROOM + body.size());
+        auto *frame = static_cast<const unsigned char *>(message.data());
+        REQUIRE(ReplyHeaderCodec::peekBodySize(frame) == body.size());
+
+        ReplyHeader decoded = ReplyHeaderCodec::decode(frame);
+        REQUIRE(decoded.service_id == header.service_id);
+        REQUIRE(decoded.msg_id == header.msg_id);
+        REQUIRE(decoded.msg_seq == header.msg_seq);
+        REQUIRE(decoded.error_code == header.error_code);
+        REQUIRE(decoded.stage_index == header.stage_index);
+        REQUIRE(std::equal(body.begin(),
+                           body.end(),
+                           frame + ReplyEncoder::HEADROOM));
+    };
+
+    SECTION("The frame is exactly header plus body")
+    {
+        checkFrame(ReplyEncoder::encode(header, body), body);
+        checkFrame(ReplyEncoder::encode(header, {}), {});
+    }
+
+    SECTION("Bodies over the packet limit are rejected")
+    {
+        std::vector<unsigned char> large(MAX_PACKET_SIZE + 1);
+        REQUIRE_THROWS_AS(ReplyEncoder::encode(header, large),
+                          std::out_of_range);
+    }
+
+    SECTION("Wrapped frames are sent from caller memory and released")
+    {
+        auto *frame = new unsigned char[ReplyEncoder::HEADROOM + body.size()];
+        std::copy(body.begin(), body.end(), frame + ReplyEncoder::HEADROOM);
+
+        int released = 0;
+        {
+            zmq::message_t message = ReplyEncoder::wrap(
+                header,
+                frame,
+                body.size(),
+                [](void *data, void *hint) {
+                    delete[] static_cast<unsigned char *>(data);
+                    (*static_cast<int *>(hint))++;
+                },
+                &released);
+
+            REQUIRE(message.data() == frame);
+            checkFrame(message, body);
+            REQUIRE(released == 0);
+        }
+        REQUIRE(released == 1);
+    }
+
+    SECTION("Encoding is reentrant")
+    {
+        // each thread encodes its own header and counts the frames that do
+        // not match it exactly
+        std::vector<int> corrupted(4, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&, t]() {
+                ReplyHeader own = header;
+                own.msg_id = t;
+                own.stage_index = static_cast<int8_t>(t);
+
+                std::vector<unsigned char> expected(ReplyEncoder::HEADROOM);
+                ReplyHeaderCodec::encode(expected.data(),
+                                         static_cast<uint16_t>(body.size()),
+                                         own);
+                expected.insert(expected.end(), body.begin(), body.end());
+
+                for (int i = 0; i < 1000; i++)
+                {
+                    auto message = ReplyEncoder::encode(own, body);
+                    auto *frame =
+                        static_cast<const unsigned char *>(message.data());
+                    if (message.size() != expected.size() ||
+                        !std::equal(expected.begin(), expected.end(), frame))
+                    {
+                        corrupted[t]++;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        REQUIRE(corrupted == std::vector<int>(4, 0));
+    }
+}
@@ -1,21 +1,26 @@
 #pragma once
+#include "mirrored_ring_buffer.hpp"
 #include "ring_buffer.hpp"
+#include <catch2/catch_template_test_macros.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 using namespace Play;
 
-TEST_CASE("RingBuffer functionality", "[RingBuffer]")
+TEMPLATE_TEST_CASE("RingBuffer functionality",
+                   "[RingBuffer]",
+                   RingBuffer,
+                   MirroredRingBuffer)
 {
     SECTION("Initialization")
     {
-        RingBuffer buf(10, 20);
+        TestType buf(10, 20);
         REQUIRE(buf.capacity() == 10);
         REQUIRE(buf.size() == 0);
     }
 
     SECTION("Push and pop single values")
     {
-        RingBuffer buf(5);
+        TestType buf(5);
         buf.push(static_cast<unsigned char>(5));
         REQUIRE(buf.size() == 1);
         REQUIRE(buf.peek() == 5);
@@ -27,7 +32,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
 
     SECTION("Push beyond capacity and resize buffer")
     {
-        RingBuffer buf(2, 5);
+        TestType buf(2, 5);
         buf.push(static_cast<unsigned char>(1));
         buf.push(static_cast<unsigned char>(2));
         REQUIRE(buf.capacity() == 2);
@@ -45,7 +50,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
     SECTION("Push and pop multiple values")
     {
         std::vector<unsigned char> data = {1, 2, 3, 4, 5};
-        RingBuffer buf(10);
+        TestType buf(10);
         buf.push(data);
 
         REQUIRE(buf.size() == 5);
@@ -61,7 +66,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
     SECTION("Clear buffer")
     {
         std::vector<unsigned char> data = {1, 2, 3, 4, 5};
-        RingBuffer buf(10);
+        TestType buf(10);
         buf.push(data);
 
         buf.clear();
@@ -74,7 +79,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
         unsigned char inputBuffer[5] = {1, 2, 3, 4, 5};
         unsigned char outputBuffer[5] = {0};
 
-        RingBuffer buf(10);
+        TestType buf(10);
         buf.write(inputBuffer, 0, 5);
 
         REQUIRE(buf.size() == 5);
@@ -92,7 +97,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
 
     SECTION("Reading and writing integers")
     {
-        RingBuffer buf(10);
+        TestType buf(10);
 
         // Boundary tests for 16-bit integers
         int16_t smallValue = -32768;
@@ -112,7 +117,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
     SECTION("Clear specific count")
     {
         std::vector<unsigned char> data = {1, 2, 3, 4, 5};
-        RingBuffer buf(10);
+        TestType buf(10);
         buf.push(data);
 
         buf.clear(3);
@@ -126,7 +131,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
         unsigned char inputBuffer[5] = {1, 2, 3, 4, 5};
         unsigned char outputBuffer[5] = {0};
 
-        RingBuffer buf(10);
+        TestType buf(10);
         buf.write(inputBuffer, 0, 5);
 
         REQUIRE(buf.size() == 5);
@@ -148,7 +153,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
         std::vector<unsigned char> inputBuffer = {1, 2, 3, 4, 5};
         unsigned char outputBuffer[5] = {0};
 
-        RingBuffer buf(10);
+        TestType buf(10);
         buf.write(std::span<const unsigned char>(inputBuffer));
 
         REQUIRE(buf.size() == 5);
@@ -166,7 +171,7 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
 
     SECTION("Read and write with invalid parameters")
     {
-        RingBuffer buf(5);
+        TestType buf(5);
 
         unsigned char buffer[5] = {1, 2, 3, 4, 5};
 
@@ -182,4 +187,199 @@ TEST_CASE("RingBuffer functionality", "[RingBuffer]")
         REQUIRE(buf.size() == 0);
         REQUIRE_THROWS_AS(buf.pop(), std::runtime_error);
     }
+
+    SECTION("Bulk write and read across the wrap point")
+    {
+        unsigned char inputBuffer[6] = {1, 2, 3, 4, 5, 6};
+        unsigned char outputBuffer[6] = {0};
+
+        TestType buf(8);
+        buf.write(inputBuffer, 0, 6);
+        buf.clear(5);
+        buf.write(inputBuffer, 0, 6);
+
+        REQUIRE(buf.size() == 7);
+        REQUIRE(buf.capacity() == 8);
+        REQUIRE(buf.pop() == 6);
+
+        size_t bytesRead = buf.read(outputBuffer, 0, 6);
+        REQUIRE(bytesRead == 6);
+
+        for (size_t i = 0; i < 6; i++)
+        {
+            REQUIRE(outputBuffer[i] == inputBuffer[i]);
+        }
+    }
+
+    SECTION("Bulk write grows once to the required capacity")
+    {
+        std::vector<unsigned char> inputBuffer(100);
+        for (size_t i = 0; i < inputBuffer.size(); i++)
+        {
+            inputBuffer[i] = static_cast<unsigned char>(i);
+        }
+
+        TestType buf(4, 128);
+        buf.write(inputBuffer.data(), 0, 3);
+        buf.clear(2);
+        buf.write(std::span<const unsigned char>(inputBuffer));
+
+        REQUIRE(buf.capacity() == 128);
+        REQUIRE(buf.size() == 101);
+        REQUIRE(buf.pop() == 2);
+
+        for (size_t i = 0; i < inputBuffer.size(); i++)
+        {
+            REQUIRE(buf.pop() == inputBuffer[i]);
+        }
+        REQUIRE(buf.size() == 0);
+
+        std::vector<unsigned char> oversized(129);
+        REQUIRE_THROWS_AS(buf.write(oversized.data(), 0, oversized.size()),
+                          std::out_of_range);
+        REQUIRE(buf.size() == 0);
+    }
+
+    SECTION("Writable and readable spans across the wrap point")
+    {
+        TestType buf(8, 64);
+        unsigned char filler[6] = {0};
+        buf.write(filler, 0, 6);
+        buf.consume(6);
+
+        auto writable = buf.writableSpans(6);
+        REQUIRE(writable[0].size() + writable[1].size() ==
+                buf.capacity() - buf.size());
+
+        unsigned char value = 1;
+        size_t written = 0;
+        for (auto span : writable)
+        {
+            for (size_t i = 0; i < span.size() && written < 6; i++, written++)
+            {
+                span[i] = value++;
+            }
+        }
+        buf.commitWrite(6);
+        REQUIRE(buf.size() == 6);
+
+        std::vector<unsigned char> readable;
+        for (auto span : buf.readableSpans())
+        {
+            readable.insert(readable.end(), span.begin(), span.end());
+        }
+        REQUIRE(readable == std::vector<unsigned char>{1, 2, 3, 4, 5, 6});
+
+        buf.consume(2);
+        REQUIRE(buf.peek() == 3);
+        REQUIRE_THROWS_AS(buf.commitWrite(buf.capacity()),
+                          std::invalid_argument);
+    }
+
+    SECTION("Writable spans grow to the requested minimum")
+    {
+        TestType buf(4, 64);
+        auto writable = buf.writableSpans(20);
+
+        REQUIRE(buf.capacity() == 32);
+        REQUIRE(writable[0].size() + writable[1].size() >= 20);
+    }
+}
+
+TEST_CASE("PowerOfTwoRingBuffer functionality", "[RingBuffer]")
+{
+    SECTION("Capacity is rounded up to a power of two")
+    {
+        PowerOfTwoRingBuffer buf(10, 32);
+        REQUIRE(buf.capacity() == 16);
+        REQUIRE(buf.size() == 0);
+
+        REQUIRE_THROWS_AS(PowerOfTwoRingBuffer(20, 20), std::invalid_argument);
+    }
+
+    SECTION("Push beyond capacity doubles within the power of two")
+    {
+        PowerOfTwoRingBuffer buf(2, 5);
+        buf.push(static_cast<unsigned char>(1));
+        buf.push(static_cast<unsigned char>(2));
+        buf.push(static_cast<unsigned char>(3));
+        REQUIRE(buf.capacity() == 4);
+        buf.push(static_cast<unsigned char>(4));
+        REQUIRE_THROWS_AS(buf.push(static_cast<unsigned char>(5)),
+                          std::out_of_range);
+    }
+
+    SECTION("Integers spanning the wrap point")
+    {
+        PowerOfTwoRingBuffer buf(8);
+        unsigned char filler[6] = {0};
+        buf.write(filler, 0, 6);
+        buf.clear(6);
+
+        int32_t value = -123456789;
+        buf.write(value);
+        REQUIRE(buf.peekInt32() == value);
+        REQUIRE(buf.readInt32() == value);
+
+        int16_t shortValue = -32768;
+        buf.write(shortValue);
+        REQUIRE(buf.readInt16() == shortValue);
+        REQUIRE(buf.size() == 0);
+        REQUIRE_THROWS_AS(buf.peekInt16(), std::out_of_range);
+    }
+}
+
+TEST_CASE("MirroredRingBuffer functionality", "[RingBuffer]")
+{
+    SECTION("Readable bytes are contiguous across the wrap point")
+    {
+        MirroredRingBuffer buf(8, 64);
+        std::vector<unsigned char> filler(buf.capacity());
+        std::vector<unsigned char> output(filler.size());
+
+        // advance the reader so the next write straddles the physical end
+        // of the ring, whatever size the region was rounded up to
+        for (size_t written = 0; written + filler.size() < 4096 * 4;
+             written += filler.size())
+        {
+            buf.write(filler.data(), 0, filler.size());
+            buf.read(output.data(), 0, output.size());
+        }
+
+        std::vector<unsigned char> input(8);
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            input[i] = static_cast<unsigned char>(i + 1);
+        }
+        for (size_t i = 0; i < 4096; i++)
+        {
+            buf.write(input.data(), 0, input.size());
+
+            auto readable = buf.readable();
+            REQUIRE(readable.size() == input.size());
+            for (size_t j = 0; j < input.size(); j++)
+            {
+                REQUIRE(readable[j] == input[j]);
+            }
+            buf.clear(input.size());
+        }
+    }
+
+    SECTION("Growing keeps the readable bytes")
+    {
+        MirroredRingBuffer buf(4, 1024 * 64);
+        std::vector<unsigned char> input(1024 * 48);
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            input[i] = static_cast<unsigned char>(i * 7);
+        }
+
+        buf.write(input.data(), 0, 3);
+        buf.clear(3);
+        buf.write(std::span<const unsigned char>(input));
+
+        REQUIRE(buf.capacity() == 1024 * 64);
+        REQUIRE(buf.size() == input.size());
+        REQUIRE(std::equal(input.begin(), input.end(), buf.data()));
+    }
 }
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
+
+#include "router_pump.hpp"
+#include "router_test_helpers.hpp"
+
+using namespace Play;
+
+namespace RouterPumpTest
+{
+
+// waits up to 100ms for `fd` to become readable, or 1ms without one
+inline void waitReadable(int fd)
+{
+#if defined(__linux__)
+    if (fd >= 0)
+    {
+        pollfd item{fd, POLLIN, 0};
+        ::poll(&item, 1, 100);
+        return;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+} // namespace RouterPumpTest
+
+TEST_CASE("RouterPump functionality", "[RouterPump]")
+{
+    using namespace RouterPumpTest;
+    using namespace RouterTest;
+    using std::chrono::milliseconds;
+
+    const std::string endpoint = "inproc://router-pump-test";
+    auto context = RouterSocket::makeContext(SocketConfig(""));
+    RouterSocket server(context, "--router_mandatory=true", endpoint);
+    server.bind();
+    RouterSocket client(context, "--router_mandatory=true", "client");
+    client.connect(endpoint);
+    handshake(client, server, endpoint);
+    drain(server);
+
+    RouterPump pump(server, 16);
+    pump.start();
+
+    SECTION("Sends from many threads all go out, stop() flushes the rest")
+    {
+        constexpr int THREADS = 4;
+        constexpr int MESSAGES = 500;
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < THREADS; t++)
+        {
+            producers.emplace_back([&pump, t]() {
+                for (int i = 0; i < MESSAGES; i++)
+                {
+                    pump.send(makeMessage("client",
+                                          std::to_string(t) + ":" +
+                                              std::to_string(i)));
+                }
+            });
+        }
+        for (auto &producer : producers)
+        {
+            producer.join();
+        }
+        // whatever the pump thread has not sent yet goes out here
+        pump.stop();
+
+        std::vector<int> next(THREADS, 0);
+        int received = 0;
+        bool ordered = true;
+        RouterMessageBatch batch(64);
+        while (received < THREADS * MESSAGES &&
+               client.recvBatch(batch, batch.capacity(), milliseconds(1000)) >
+                   0)
+        {
+            for (RouterMessage &message : batch)
+            {
+                std::string body = text(message.body());
+                size_t colon = body.find(':');
+                int thread = std::stoi(body.substr(0, colon));
+                int index = std::stoi(body.substr(colon + 1));
+                // one producer's messages keep their order
+                ordered = ordered && index == next[thread];
+                next[thread] = index + 1;
+                received++;
+            }
+        }
+        REQUIRE(received == THREADS * MESSAGES);
+        REQUIRE(ordered);
+    }
+
+    SECTION("Inbound messages are drained in batches after the event fd")
+    {
+        constexpr int MESSAGES = 100;
+        for (int i = 0; i < MESSAGES; i++)
+        {
+            RouterMessage message = makeMessage(endpoint, std::to_string(i));
+            REQUIRE(client.send(message));
+        }
+
+        int fd = pump.recvEventFd();
+        std::vector<RouterMessage> messages(8);
+        int received = 0;
+        bool ordered = true;
+        auto deadline = std::chrono::steady_clock::now() + milliseconds(5000);
+        while (received < MESSAGES &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            waitReadable(fd);
+
+            size_t count = 0;
+            while ((count = pump.recvBatch(messages, messages.size())) > 0)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    bool fromClient = text(messages[i].target()) == "client";
+                    bool inOrder =
+                        text(messages[i].body()) == std::to_string(received);
+                    ordered = ordered && fromClient && inOrder;
+                    received++;
+                }
+            }
+        }
+        REQUIRE(received == MESSAGES);
+        REQUIRE(ordered);
+
+        RouterMessage message;
+        REQUIRE_FALSE(pump.tryRecv(message));
+        pump.stop();
+    }
+}
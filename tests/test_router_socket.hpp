@@ -0,0 +1,118 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <string>
+
+#include "router_socket.hpp"
+#include "router_test_helpers.hpp"
+
+using namespace Play;
+
+TEST_CASE("RouterSocket batch receive", "[RouterSocket]")
+{
+    using namespace RouterTest;
+    using std::chrono::milliseconds;
+
+    const std::string endpoint = "inproc://router-socket-test";
+    auto context = RouterSocket::makeContext(SocketConfig(""));
+    RouterSocket server(context, "--router_mandatory=true", endpoint);
+    server.bind();
+    RouterSocket client(context, "--router_mandatory=true", "client");
+    client.connect(endpoint);
+
+    sendWhenConnected(client, endpoint, "0");
+    for (int i = 1; i < 5; i++)
+    {
+        RouterMessage message = makeMessage(endpoint, std::to_string(i));
+        REQUIRE(client.send(message));
+    }
+
+    RouterMessageBatch batch(8);
+
+    SECTION("A batch drains up to max messages")
+    {
+        REQUIRE(server.recvBatch(batch, 3, milliseconds(1000)) == 3);
+        REQUIRE(batch.size() == 3);
+        for (int i = 0; i < 3; i++)
+        {
+            REQUIRE(text(batch[i].target()) == "client");
+            REQUIRE(text(batch[i].Header()) == "h");
+            REQUIRE(text(batch[i].body()) == std::to_string(i));
+        }
+
+        REQUIRE(server.recvBatch(batch, 8, milliseconds(1000)) == 2);
+        REQUIRE(text(batch[0].body()) == "3");
+        REQUIRE(text(batch[1].body()) == "4");
+
+        REQUIRE(server.recvBatch(batch, 8, milliseconds(0)) == 0);
+        REQUIRE(batch.empty());
+    }
+
+    SECTION("Slots are reused after a message is moved out")
+    {
+        REQUIRE(server.recvBatch(batch, 2, milliseconds(1000)) == 2);
+        RouterMessage kept = std::move(batch[0]);
+
+        REQUIRE(server.recvBatch(batch, 2, milliseconds(1000)) == 2);
+        REQUIRE(text(batch[0].body()) == "2");
+        REQUIRE(text(batch[1].body()) == "3");
+        REQUIRE(text(kept.target()) == "client");
+        REQUIRE(text(kept.body()) == "0");
+
+        // the reply goes back through the received identity
+        RouterMessage reply(std::move(kept.target()),
+                            zmq::message_t("r", 1),
+                            zmq::message_t("ok", 2));
+        REQUIRE(server.send(reply));
+        RouterMessageBatch replies(1);
+        REQUIRE(client.recvBatch(replies, 1, milliseconds(1000)) == 1);
+        REQUIRE(text(replies[0].body()) == "ok");
+    }
+
+    SECTION("Messages without exactly three parts are discarded")
+    {
+        REQUIRE(server.recvBatch(batch, 5, milliseconds(1000)) == 5);
+
+        zmq::socket_t raw(*context, zmq::socket_type::router);
+        raw.set(zmq::sockopt::routing_id, "raw");
+        raw.connect(endpoint);
+
+        // sends a message the server receives as `parts` parts: the raw
+        // socket's identity, then everything after the target
+        auto sendParts = [&raw, &endpoint](int parts) {
+            raw.send(zmq::message_t(endpoint.data(), endpoint.size()),
+                     zmq::send_flags::sndmore);
+            for (int i = 1; i < parts; i++)
+            {
+                raw.send(zmq::message_t("p", 1),
+                         i + 1 < parts ? zmq::send_flags::sndmore
+                                       : zmq::send_flags::none);
+            }
+        };
+        // a ROUTER drops messages to a peer it has not attached yet, so
+        // send valid ones until the first arrives, then drain the rest
+        do
+        {
+            sendParts(3);
+        } while (server.recvBatch(batch, 8, milliseconds(10)) == 0);
+        while (server.recvBatch(batch, 8, milliseconds(10)) > 0)
+        {
+        }
+
+        sendParts(2);
+        sendParts(4);
+        sendParts(3);
+
+        size_t received = 0;
+        auto deadline = std::chrono::steady_clock::now() + milliseconds(1000);
+        while (received == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            received = server.recvBatch(batch, 8, milliseconds(100));
+        }
+        REQUIRE(received == 1);
+        REQUIRE(text(batch[0].target()) == "raw");
+        REQUIRE(text(batch[0].body()) == "p");
+        REQUIRE(server.recvBatch(batch, 8, milliseconds(0)) == 0);
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "send_coalescer.hpp"
+
+using namespace Play;
+
+TEST_CASE("SendCoalescer functionality", "[SendCoalescer]")
+{
+    SendCoalescer coalescer;
+    std::vector<std::string> writes;
+    auto write = [&writes](std::span<const unsigned char> data) {
+        writes.emplace_back(data.begin(), data.end());
+    };
+    auto bytes = [](const char *text) {
+        return std::span<const unsigned char>(
+            reinterpret_cast<const unsigned char *>(text),
+            std::strlen(text));
+    };
+
+    SECTION("Frames are written together on flush")
+    {
+        REQUIRE(coalescer.append({}, bytes("ab"), 1024, write));
+        // already waiting for a flush
+        REQUIRE_FALSE(coalescer.append({}, bytes("cd"), 1024, write));
+        REQUIRE_FALSE(coalescer.append(bytes("<"), bytes("ef"), 1024, write));
+        REQUIRE(writes.empty());
+        REQUIRE(coalescer.stagedBytes() == 7);
+
+        REQUIRE(coalescer.flush(write) == 3);
+        REQUIRE(writes == std::vector<std::string>{"abcd<ef"});
+        REQUIRE(coalescer.stagedBytes() == 0);
+
+        // nothing left to write
+        REQUIRE(coalescer.flush(write) == 0);
+        REQUIRE(writes.size() == 1);
+
+        // the next frame asks for a flush again
+        REQUIRE(coalescer.append({}, bytes("gh"), 1024, write));
+    }
+
+    SECTION("Reaching the byte threshold writes at once")
+    {
+        REQUIRE(coalescer.append({}, bytes("abc"), 6, write));
+        REQUIRE_FALSE(coalescer.append({}, bytes("def"), 6, write));
+        REQUIRE(writes == std::vector<std::string>{"abcdef"});
+
+        // the pending flush request finds nothing to write
+        REQUIRE(coalescer.flush(write) == 0);
+    }
+
+    SECTION("Flushes are counted by frames per write")
+    {
+        int64_t flushes = SendCoalescingStats::flushes();
+        int64_t frames = SendCoalescingStats::frames();
+        int64_t single = SendCoalescingStats::flushesWithFrames(0);
+        int64_t fourToSeven = SendCoalescingStats::flushesWithFrames(2);
+
+        coalescer.append({}, bytes("a"), 1024, write);
+        coalescer.flush(write);
+        for (int i = 0; i < 5; i++)
+        {
+            coalescer.append({}, bytes("b"), 1024, write);
+        }
+        coalescer.flush(write);
+
+        REQUIRE(SendCoalescingStats::flushes() - flushes == 2);
+        REQUIRE(SendCoalescingStats::frames() - frames == 6);
+        REQUIRE(SendCoalescingStats::flushesWithFrames(0) - single == 1);
+        REQUIRE(SendCoalescingStats::flushesWithFrames(2) - fourToSeven == 1);
+    }
+
+    SECTION("Concurrent appends keep every frame whole and in order")
+    {
+        std::string written;
+        auto collect = [&written](std::span<const unsigned char> data) {
+            written.append(data.begin(), data.end());
+        };
+
+        std::vector<std::thread> threads;
+        for (char tag = 'a'; tag < 'e'; tag++)
+        {
+            threads.emplace_back([&, tag]() {
+                for (int i = 0; i < 1000; i++)
+                {
+                    std::string frame = std::string(1, tag) +
+                                        std::to_string(i % 10) + ";";
+                    coalescer.append(bytes(frame.c_str()), {}, 64, collect);
+                    if (i % 100 == 0)
+                    {
+                        coalescer.flush(collect);
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        coalescer.flush(collect);
+
+        REQUIRE(written.size() == 4 * 1000 * 3);
+        std::array<int, 4> next{};
+        for (size_t i = 0; i < written.size(); i += 3)
+        {
+            int tag = written[i] - 'a';
+            REQUIRE(written[i + 1] - '0' == next[tag] % 10);
+            REQUIRE(written[i + 2] == ';');
+            next[tag]++;
+        }
+    }
+}
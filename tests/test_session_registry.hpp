@@ -0,0 +1,277 @@
+#pragma once
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+#include "session_registry.hpp"
+
+using namespace Play;
+
+namespace
+{
+struct FakeSession
+{
+    static constexpr uint64_t ALIVE = 0x5E5510A11FE;
+
+    int64_t sid = 0;
+    std::atomic<uint64_t> canary{ALIVE};
+
+    ~FakeSession()
+    {
+        canary.store(0, std::memory_order_relaxed);
+    }
+};
+} // namespace
+
+using FakeRegistry = SessionRegistry<FakeSession>;
+
+TEST_CASE("SessionRegistry functionality", "[SessionRegistry]")
+{
+    FakeRegistry registry;
+
+    SECTION("Insert and find")
+    {
+        auto session = std::make_shared<FakeSession>();
+        int64_t sid = registry.insert(session);
+
+        auto guard = registry.pin();
+        REQUIRE(sid > 0);
+        REQUIRE(registry.find(sid, guard) == session.get());
+        REQUIRE(registry.size() == 1);
+        REQUIRE(registry.find(sid + 1, guard) == nullptr);
+        REQUIRE(registry.find(0, guard) == nullptr);
+        REQUIRE(registry.find(-1, guard) == nullptr);
+    }
+
+    SECTION("Removed sids are rejected")
+    {
+        int64_t sid = registry.insert(std::make_shared<FakeSession>());
+        REQUIRE(registry.remove(sid));
+        REQUIRE(registry.find(sid, registry.pin()) == nullptr);
+        REQUIRE_FALSE(registry.remove(sid));
+        REQUIRE(registry.size() == 0);
+    }
+
+    SECTION("A reused slot gets a new generation")
+    {
+        std::vector<int64_t> sids;
+        for (int i = 0; i < 4; i++)
+        {
+            sids.push_back(registry.insert(std::make_shared<FakeSession>()));
+        }
+        for (int64_t sid : sids)
+        {
+            registry.remove(sid);
+        }
+
+        // the oldest freed slot comes back first, under a different sid
+        auto session = std::make_shared<FakeSession>();
+        int64_t sid = registry.insert(session);
+        REQUIRE(static_cast<uint32_t>(sid) ==
+                static_cast<uint32_t>(sids.front()));
+        REQUIRE(sid != sids.front());
+        auto guard = registry.pin();
+        REQUIRE(registry.find(sids.front(), guard) == nullptr);
+        REQUIRE(registry.find(sid, guard) == session.get());
+    }
+
+    SECTION("A session found under a guard outlives its removal")
+    {
+        auto session = std::make_shared<FakeSession>();
+        std::weak_ptr<FakeSession> watched = session;
+        int64_t sid = registry.insert(std::move(session));
+        {
+            auto guard = registry.pin();
+            FakeSession *found = registry.find(sid, guard);
+            registry.remove(sid);
+            // later removals cannot reclaim it while the guard lives
+            registry.remove(registry.insert(std::make_shared<FakeSession>()));
+            registry.remove(registry.insert(std::make_shared<FakeSession>()));
+
+            REQUIRE_FALSE(watched.expired());
+            REQUIRE(found->canary == FakeSession::ALIVE);
+            REQUIRE(registry.retired() > 0);
+        }
+
+        // the next removal finds no reader left in the old epochs
+        registry.remove(registry.insert(std::make_shared<FakeSession>()));
+        REQUIRE(watched.expired());
+        REQUIRE(registry.retired() == 0);
+    }
+
+    SECTION("Removed sessions are released at once without readers")
+    {
+        auto session = std::make_shared<FakeSession>();
+        int64_t sid = registry.insert(session);
+        registry.remove(sid);
+
+        REQUIRE(session.use_count() == 1);
+        REQUIRE(registry.retired() == 0);
+    }
+
+    SECTION("forEach visits registered sessions only")
+    {
+        std::vector<int64_t> sids;
+        for (int i = 0; i < 3000; i++)
+        {
+            sids.push_back(registry.insert(std::make_shared<FakeSession>()));
+        }
+        for (size_t i = 0; i < sids.size(); i += 2)
+        {
+            registry.remove(sids[i]);
+        }
+
+        size_t visited = 0;
+        registry.forEach([&](int64_t sid, FakeSession &) {
+            REQUIRE(registry.find(sid, registry.pin()) != nullptr);
+            visited++;
+        });
+        REQUIRE(visited == 1500);
+    }
+
+    SECTION("clear drops every session")
+    {
+        auto session = std::make_shared<FakeSession>();
+        int64_t sid = registry.insert(session);
+        registry.clear();
+
+        REQUIRE(registry.find(sid, registry.pin()) == nullptr);
+        REQUIRE(registry.size() == 0);
+        REQUIRE(session.use_count() == 1);
+        REQUIRE(registry.insert(std::make_shared<FakeSession>()) != sid);
+    }
+}
+
+TEST_CASE("SessionRegistry concurrent lookups", "[SessionRegistry]")
+{
+    FakeRegistry registry;
+    std::atomic<bool> done{false};
+    std::vector<int64_t> published(64, 0);
+    std::atomic<int64_t> misdelivered{0};
+
+    // churns sessions through a small set of sids while readers look up
+    // sids that may already be stale
+    std::thread writer([&]() {
+        for (size_t round = 0; round < 20000; round++)
+        {
+            size_t index = round % published.size();
+            int64_t old =
+                std::atomic_ref<int64_t>(published[index]).load();
+            if (old != 0)
+            {
+                registry.remove(old);
+            }
+
+            auto session = std::make_shared<FakeSession>();
+            int64_t sid = registry.insert(session);
+            std::atomic_ref<int64_t>(session->sid).store(sid);
+            std::atomic_ref<int64_t>(published[index]).store(sid);
+        }
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back([&]() {
+            while (!done)
+            {
+                for (auto &slot : published)
+                {
+                    int64_t sid = std::atomic_ref<int64_t>(slot).load();
+                    auto guard = registry.pin();
+                    FakeSession *session = registry.find(sid, guard);
+                    // sid is written after insert, so 0 is a session being
+                    // set up; any other value must match
+                    if (session != nullptr)
+                    {
+                        int64_t seen =
+                            std::atomic_ref<int64_t>(session->sid).load();
+                        if (seen != 0 && seen != sid)
+                        {
+                            misdelivered++;
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    writer.join();
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+    REQUIRE(misdelivered == 0);
+}
+
+TEST_CASE("SessionRegistry lookups race removal and clear", "[SessionRegistry]")
+{
+    FakeRegistry registry;
+    std::atomic<bool> done{false};
+    std::vector<int64_t> published(64, 0);
+    std::atomic<int64_t> destroyedInUse{0};
+
+    // removes every session right after inserting it and clears the
+    // registry now and then, the way close() does
+    std::thread writer([&]() {
+        for (size_t round = 0; round < 20000; round++)
+        {
+            size_t index = round % published.size();
+            int64_t sid = registry.insert(std::make_shared<FakeSession>());
+            std::atomic_ref<int64_t>(published[index]).store(sid);
+            if (round % 500 == 499)
+            {
+                registry.clear();
+            }
+            else
+            {
+                registry.remove(sid);
+            }
+        }
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++)
+    {
+        readers.emplace_back([&]() {
+            while (!done)
+            {
+                for (auto &slot : published)
+                {
+                    int64_t sid = std::atomic_ref<int64_t>(slot).load();
+                    auto guard = registry.pin();
+                    FakeSession *session = registry.find(sid, guard);
+                    if (session == nullptr)
+                    {
+                        continue;
+                    }
+                    // the writer has removed it by now, or will while the
+                    // session is in use here
+                    for (int i = 0; i < 16; i++)
+                    {
+                        if (session->canary.load(std::memory_order_relaxed) !=
+                            FakeSession::ALIVE)
+                        {
+                            destroyedInUse++;
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    writer.join();
+    for (auto &reader : readers)
+    {
+        reader.join();
+    }
+    REQUIRE(destroyedInUse == 0);
+    REQUIRE(registry.size() == 0);
+    // with the readers gone, one more removal reclaims what they held up
+    registry.remove(registry.insert(std::make_shared<FakeSession>()));
+    REQUIRE(registry.retired() == 0);
+}
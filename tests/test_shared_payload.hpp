@@ -0,0 +1,61 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "shared_payload.hpp"
+
+using namespace Play;
+
+TEST_CASE("SharedPayload functionality", "[SharedPayload]")
+{
+    SECTION("Payload bytes are kept as given")
+    {
+        std::vector<unsigned char> data{1, 2, 3, 4, 5};
+        SharedPayload payload(data);
+
+        auto bytes = payload.bytes();
+        REQUIRE(payload.size() == 5);
+        REQUIRE(std::vector<unsigned char>(bytes.begin(), bytes.end()) ==
+                data);
+    }
+
+    SECTION("WebSocket frame header sits right before the payload")
+    {
+        std::vector<unsigned char> small(10, 0xAB);
+        SharedPayload smallPayload(small);
+        auto frame = smallPayload.wsFrame();
+        REQUIRE(frame.size() == 12);
+        REQUIRE(frame[0] == 0x82);
+        REQUIRE(frame[1] == 10);
+        REQUIRE(frame[2] == 0xAB);
+        REQUIRE(frame[11] == 0xAB);
+
+        std::vector<unsigned char> large(70000, 0xCD);
+        SharedPayload largePayload(large);
+        frame = largePayload.wsFrame();
+        REQUIRE(frame.size() == 70010);
+        REQUIRE(frame[1] == 127);
+        REQUIRE(frame[10] == 0xCD);
+        REQUIRE(largePayload.bytes().data() == frame.data() + 10);
+    }
+
+    SECTION("Copies share one buffer")
+    {
+        std::vector<unsigned char> data{9, 8, 7};
+        SharedPayload payload(data);
+        std::vector<SharedPayload> queued(100, payload);
+
+        REQUIRE(payload.useCount() == 101);
+        REQUIRE(queued.back().bytes().data() == payload.bytes().data());
+        queued.clear();
+        REQUIRE(payload.useCount() == 1);
+    }
+
+    SECTION("Empty payloads frame to a bare header")
+    {
+        SharedPayload payload(std::span<const unsigned char>{});
+        REQUIRE(payload.bytes().empty());
+        REQUIRE(payload.wsFrame().size() == 2);
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+#include <vector>
+
+#include "stage_dispatcher.hpp"
+
+using namespace Play;
+
+TEST_CASE("StageDispatcher functionality", "[StageDispatcher]")
+{
+    auto message = [](int64_t sid, int8_t stage, int32_t msgId = 0) {
+        const unsigned char body[] = {1};
+        return std::make_unique<ClientMessage>(sid,
+                                               Header(1, msgId, 0, stage),
+                                               body,
+                                               sizeof(body));
+    };
+    auto drain = [](ReceiveQueue &mailbox) {
+        std::vector<std::unique_ptr<ClientMessage>> messages;
+        while (auto popped = mailbox.tryPop())
+        {
+            messages.push_back(std::move(popped));
+        }
+        return messages;
+    };
+
+    SECTION("Messages of one stage meet one worker")
+    {
+        StageDispatcher dispatcher({4, DispatchKey::StageIndex}, 1);
+        for (int64_t sid = 1; sid <= 8; sid++)
+        {
+            dispatcher.push(0, message(sid, 6));
+            dispatcher.push(0, message(sid, 3));
+        }
+
+        REQUIRE(drain(dispatcher.mailbox(2)).size() == 8);
+        REQUIRE(drain(dispatcher.mailbox(3)).size() == 8);
+        REQUIRE(drain(dispatcher.mailbox(0)).empty());
+        REQUIRE(drain(dispatcher.mailbox(1)).empty());
+    }
+
+    SECTION("Negative stage indexes map to a valid worker")
+    {
+        StageDispatcher dispatcher({3, DispatchKey::StageIndex}, 1);
+        REQUIRE(dispatcher.mailboxFor(*message(1, -1)) == 255 % 3);
+    }
+
+    SECTION("Connection events reach every stage worker")
+    {
+        StageDispatcher dispatcher({3, DispatchKey::StageIndex}, 1);
+        dispatcher.push(0, std::make_unique<ClientMessage>(7, CONNECT));
+        dispatcher.push(0, std::make_unique<ClientMessage>(7, DISCONNECT));
+
+        for (size_t worker = 0; worker < 3; worker++)
+        {
+            auto messages = drain(dispatcher.mailbox(worker));
+            REQUIRE(messages.size() == 2);
+            REQUIRE(messages[0]->type() == CONNECT);
+            REQUIRE(messages[1]->type() == DISCONNECT);
+            REQUIRE(messages[1]->sid() == 7);
+        }
+    }
+
+    SECTION("Dispatching by sid keeps a session on its own worker")
+    {
+        StageDispatcher dispatcher({4, DispatchKey::Sid}, 1);
+        dispatcher.push(0, std::make_unique<ClientMessage>(5, CONNECT));
+        dispatcher.push(0, message(5, 0));
+        dispatcher.push(0, message(5, 3));
+
+        auto messages = drain(dispatcher.mailbox(1));
+        REQUIRE(messages.size() == 3);
+        REQUIRE(messages[0]->type() == CONNECT);
+        for (size_t worker : {0, 2, 3})
+        {
+            REQUIRE(drain(dispatcher.mailbox(worker)).empty());
+        }
+    }
+
+    SECTION("Each worker sees its stages in order")
+    {
+        const size_t workers = 4;
+        const int32_t perStage = 5000;
+        StageDispatcher dispatcher({workers, DispatchKey::StageIndex}, 2);
+
+        // two I/O threads, each producing for its own set of stages
+        std::vector<std::thread> producers;
+        for (size_t shard = 0; shard < 2; shard++)
+        {
+            producers.emplace_back([&, shard]() {
+                for (int32_t i = 0; i < perStage; i++)
+                {
+                    for (int8_t stage = static_cast<int8_t>(shard); stage < 8;
+                         stage += 2)
+                    {
+                        dispatcher.push(shard, message(1, stage, i));
+                    }
+                }
+            });
+        }
+
+        std::vector<std::thread> consumers;
+        std::array<bool, workers> ordered{};
+        for (size_t worker = 0; worker < workers; worker++)
+        {
+            consumers.emplace_back([&, worker]() {
+                std::array<int32_t, 8> next{};
+                bool inOrder = true;
+                for (int32_t received = 0; received < 2 * perStage;
+                     received++)
+                {
+                    auto popped = dispatcher.mailbox(worker).waitPop(
+                        std::chrono::seconds(5));
+                    if (popped == nullptr)
+                    {
+                        inOrder = false;
+                        break;
+                    }
+                    auto stage = static_cast<size_t>(
+                        popped->header().stage_index);
+                    inOrder = inOrder && stage % workers == worker &&
+                              popped->header().msg_id == next[stage]++;
+                }
+                ordered[worker] = inOrder;
+            });
+        }
+
+        for (auto &producer : producers)
+        {
+            producer.join();
+        }
+        for (auto &consumer : consumers)
+        {
+            consumer.join();
+        }
+        for (bool inOrder : ordered)
+        {
+            REQUIRE(inOrder);
+        }
+    }
+}
@@ -43,7 +43,8 @@ TEST_CASE("StreamParser - Single complete message parsing", "[StreamParser]")
     parser.write(data, 0, data_size);
 
     // Parse the data and get the messages
-    std::list<std::unique_ptr<ClientMessage>> messages = parser.parse();
+    std::vector<std::unique_ptr<ClientMessage>> messages;
+    parser.parse(messages);
 
     REQUIRE(messages.size() == 1);
 
@@ -112,13 +113,15 @@ TEST_CASE("StreamParser - Two complete messages at once", "[StreamParser]")
         0x00,
         0x00,
         0x00,
+        0x00,
         0x00};
     size_t data_size = sizeof(data);
 
     parser.write(data, 0, data_size);
 
     // Parse the data and get the messages
-    std::list<std::unique_ptr<ClientMessage>> messages = parser.parse();
+    std::vector<std::unique_ptr<ClientMessage>> messages;
+    parser.parse(messages);
 
     REQUIRE(messages.size() == 2);
 
@@ -133,8 +136,7 @@ TEST_CASE("StreamParser - Two complete messages at once", "[StreamParser]")
     REQUIRE(header1.stage_index == 2);
 
     // Second message
-    messages.pop_front();
-    const ClientMessage &message2 = *messages.front();
+    const ClientMessage &message2 = *messages.back();
     REQUIRE(message2.sid() == sid);
 
     const Header &header2 = message2.header();
@@ -170,7 +172,8 @@ TEST_CASE("StreamParser - Partial message received", "[StreamParser]")
     parser.write(data, 0, data_size);
 
     // Parse the data and get the messages
-    std::list<std::unique_ptr<ClientMessage>> messages = parser.parse();
+    std::vector<std::unique_ptr<ClientMessage>> messages;
+    parser.parse(messages);
 
     REQUIRE(messages.size() == 0); // No message should be parsed yet
 
@@ -195,7 +198,7 @@ TEST_CASE("StreamParser - Partial message received", "[StreamParser]")
     parser.write(body_data, 0, body_data_size);
 
     // Parse the data and get the messages again
-    messages = parser.parse();
+    parser.parse(messages);
 
     REQUIRE(messages.size() == 1);
 
@@ -209,4 +212,146 @@ TEST_CASE("StreamParser - Partial message received", "[StreamParser]")
     REQUIRE(header.stage_index == 1);
 }
 
+// drains the parser through a callback sink, returning the frame count
+static size_t parseCount(Play::StreamParser &parser)
+{
+    size_t count = 0;
+    parser.parse([&count](std::unique_ptr<ClientMessage>) { count++; });
+    return count;
+}
+
+TEST_CASE("StreamParser - Idle buffer reclaim", "[StreamParser]")
+{
+    const int64_t sid = 4321;
+    const auto idle = std::chrono::seconds(11);
+    BufferReclaimPolicy policy;
+    policy.idleTimeout = std::chrono::seconds(10);
+
+    // all-zero bytes decode as a stream of empty-bodied 11 byte frames
+    std::vector<unsigned char> burst(HEADER_SIZE * 2500, 0);
+    std::vector<unsigned char> partial(HEADER_SIZE + 5, 0);
+
+    int64_t bytesBefore = ParserBufferStats::bytes();
+
+    SECTION("An empty idle buffer is released")
+    {
+        Play::StreamParser parser(sid, policy);
+        REQUIRE(parser.bufferCapacity() == PARSER_BUFFER_CAPACITY);
+
+        parser.write(burst.data(), 0, burst.size());
+        REQUIRE(parser.bufferCapacity() == PARSER_BUFFER_CAPACITY * 4);
+        REQUIRE(parseCount(parser) == 2500);
+        REQUIRE(ParserBufferStats::bytes() - bytesBefore ==
+                static_cast<int64_t>(PARSER_BUFFER_CAPACITY * 4));
+        REQUIRE(ParserBufferStats::pool().pooledBytes >=
+                PARSER_BUFFER_CAPACITY * 4);
+
+        REQUIRE_FALSE(parser.reclaim(std::chrono::steady_clock::now()));
+        REQUIRE(parser.reclaim(std::chrono::steady_clock::now() + idle));
+        REQUIRE(parser.bufferCapacity() == 0);
+        REQUIRE(ParserBufferStats::bytes() == bytesBefore);
+
+        // the next write allocates the base capacity again
+        parser.write(partial.data(), 0, partial.size());
+        REQUIRE(parser.bufferCapacity() == PARSER_BUFFER_CAPACITY);
+        REQUIRE(parseCount(parser) == 1);
+        REQUIRE_FALSE(parser.reclaim(std::chrono::steady_clock::now() + idle));
+    }
+
+    SECTION("A grown buffer below the low watermark shrinks to base")
+    {
+        policy.releaseWhenEmpty = false;
+        Play::StreamParser parser(sid, policy);
+
+        parser.write(burst.data(), 0, burst.size());
+        parser.write(partial.data(), 0, partial.size());
+        REQUIRE(parseCount(parser) == 2501);
+
+        REQUIRE(parser.reclaim(std::chrono::steady_clock::now() + idle));
+        REQUIRE(parser.bufferCapacity() == PARSER_BUFFER_CAPACITY);
+        REQUIRE(ParserBufferStats::bytes() - bytesBefore ==
+                static_cast<int64_t>(PARSER_BUFFER_CAPACITY));
+
+        // the partial frame survives the shrink
+        std::vector<unsigned char> rest(HEADER_SIZE - 5, 0);
+        parser.write(rest.data(), 0, rest.size());
+        REQUIRE(parseCount(parser) == 1);
+    }
+
+    REQUIRE(ParserBufferStats::bytes() == bytesBefore);
+}
+
 // Add more test cases here to cover different scenarios
+
+// frames encoded the way the parser expects them, body bytes set to msg_id
+static std::vector<unsigned char> makeFrames(int32_t count, uint16_t bodySize)
+{
+    std::vector<unsigned char> frames;
+
+    for (int32_t i = 0; i < count; i++)
+    {
+        Header header(7, i, static_cast<int16_t>(i), 1);
+
+        size_t offset = frames.size();
+        frames.resize(offset + HEADER_SIZE + bodySize,
+                      static_cast<unsigned char>(i));
+        ClientHeaderCodec::encode(frames.data() + offset, bodySize, header);
+    }
+    return frames;
+}
+
+TEST_CASE("StreamParser - Direct parse from the received chunk",
+          "[StreamParser]")
+{
+    const int32_t count = 50;
+    const uint16_t bodySize = 37;
+    auto frames = makeFrames(count, bodySize);
+    Play::StreamParser parser(99);
+
+    std::vector<std::unique_ptr<ClientMessage>> messages;
+    auto parseChunked = [&](size_t chunkSize) {
+        for (size_t offset = 0; offset < frames.size(); offset += chunkSize)
+        {
+            size_t size = std::min(chunkSize, frames.size() - offset);
+            parser.parse(frames.data(), offset, size, messages);
+        }
+    };
+
+    SECTION("Whole frames in one chunk")
+    {
+        parseChunked(frames.size());
+    }
+
+    SECTION("A byte at a time")
+    {
+        parseChunked(1);
+    }
+
+    SECTION("Chunks splitting headers and bodies")
+    {
+        parseChunked(7);
+        parseChunked(HEADER_SIZE + bodySize + 5);
+    }
+
+    REQUIRE(messages.size() % count == 0);
+    REQUIRE_FALSE(messages.empty());
+    for (size_t i = 0; i < messages.size(); i++)
+    {
+        int32_t id = static_cast<int32_t>(i % count);
+        const Header &header = messages[i]->header();
+        REQUIRE(messages[i]->sid() == 99);
+        REQUIRE(header.service_id == 7);
+        REQUIRE(header.msg_id == id);
+        REQUIRE(header.msg_seq == id);
+        REQUIRE(header.stage_index == 1);
+
+        auto body = messages[i]->body();
+        REQUIRE(body->size() == bodySize);
+        auto *bytes = static_cast<const unsigned char *>(body->data());
+        REQUIRE(bytes[0] == static_cast<unsigned char>(id));
+        REQUIRE(bytes[bodySize - 1] == static_cast<unsigned char>(id));
+    }
+
+    // nothing is left behind in the ring
+    REQUIRE(parser.parse().empty());
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "timer_wheel.hpp"
+
+using namespace Play;
+
+TEST_CASE("TimerWheel functionality", "[TimerWheel]")
+{
+    TimerWheel<int64_t> wheel;
+    std::vector<std::pair<int64_t, uint64_t>> fired;
+    auto record = [&fired, &wheel](int64_t key, uint64_t) {
+        // fired entries see the tick they were due at as already passed
+        fired.emplace_back(key, wheel.current() - 1);
+    };
+
+    SECTION("Entries fire on their deadline tick")
+    {
+        wheel.schedule(1, 3);
+        wheel.schedule(2, 0);
+        wheel.schedule(3, 63);
+        REQUIRE(wheel.size() == 3);
+
+        wheel.advance(2, record);
+        REQUIRE(fired == std::vector<std::pair<int64_t, uint64_t>>{{2, 0}});
+
+        wheel.advance(100, record);
+        REQUIRE(fired == std::vector<std::pair<int64_t, uint64_t>>{
+                             {2, 0},
+                             {1, 3},
+                             {3, 63}});
+        REQUIRE(wheel.size() == 0);
+    }
+
+    SECTION("Deadlines across every level cascade down exactly")
+    {
+        std::mt19937_64 random(7);
+        std::map<int64_t, uint64_t> deadlines;
+        for (int64_t key = 0; key < 5000; key++)
+        {
+            uint64_t deadline = random() % (1u << 20);
+            deadlines[key] = deadline;
+            wheel.schedule(key, deadline);
+        }
+
+        wheel.advance(1u << 20, record);
+
+        REQUIRE(fired.size() == deadlines.size());
+        for (const auto &[key, tick] : fired)
+        {
+            REQUIRE(deadlines[key] == tick);
+        }
+    }
+
+    SECTION("Past deadlines fire on the next tick")
+    {
+        wheel.advance(10, record);
+        wheel.schedule(1, 4);
+        wheel.advance(11, record);
+        REQUIRE(fired == std::vector<std::pair<int64_t, uint64_t>>{{1, 11}});
+    }
+
+    SECTION("Deadlines beyond the range are parked until due")
+    {
+        uint64_t far = TimerWheel<int64_t>::RANGE * 2 + 5;
+        wheel.schedule(1, far);
+
+        wheel.advance(far - 1, record);
+        REQUIRE(fired.empty());
+        REQUIRE(wheel.size() == 1);
+
+        wheel.advance(far, record);
+        REQUIRE(fired == std::vector<std::pair<int64_t, uint64_t>>{{1, far}});
+    }
+
+    SECTION("Entries rescheduled from fire() land on a later tick")
+    {
+        int rounds = 0;
+        wheel.schedule(1, 5);
+        wheel.advance(1000, [&](int64_t key, uint64_t deadline) {
+            rounds++;
+            if (rounds < 4)
+            {
+                wheel.schedule(key, deadline + 100);
+            }
+        });
+        REQUIRE(rounds == 4);
+        REQUIRE(wheel.size() == 0);
+    }
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#if defined(PLAYSOCKET_IO_URING)
+
+#include <arpa/inet.h>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "header_codec.hpp"
+#include "uring_stream_socket.hpp"
+
+using namespace Play;
+
+namespace UringTest
+{
+
+// a blocking loopback client whose reads give up after five seconds
+inline int connectTo(int32_t port)
+{
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(fd,
+                  reinterpret_cast<sockaddr *>(&address),
+                  sizeof(address)) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("uring test connect failed");
+    }
+    timeval timeout{5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+inline std::vector<unsigned char> frame(const Header &header,
+                                        const std::string &body)
+{
+    std::vector<unsigned char> bytes(ClientHeaderCodec::SIZE + body.size());
+    ClientHeaderCodec::encode(bytes.data(),
+                              static_cast<uint16_t>(body.size()),
+                              header);
+    std::copy(body.begin(),
+              body.end(),
+              bytes.begin() + ClientHeaderCodec::SIZE);
+    return bytes;
+}
+
+inline void writeAll(int fd, const unsigned char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written <= 0)
+        {
+            throw std::runtime_error("uring test send failed");
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+inline std::string readExactly(int fd, size_t size)
+{
+    std::string bytes(size, '\0');
+    size_t offset = 0;
+    while (offset < size)
+    {
+        ssize_t read = ::recv(fd, bytes.data() + offset, size - offset, 0);
+        if (read <= 0)
+        {
+            throw std::runtime_error("uring test recv failed");
+        }
+        offset += static_cast<size_t>(read);
+    }
+    return bytes;
+}
+
+inline std::string text(const ClientMessage &message)
+{
+    auto body = message.bodyView();
+    return std::string(reinterpret_cast<const char *>(body.data()),
+                       body.size());
+}
+
+} // namespace UringTest
+
+TEST_CASE("UringStreamSocket connect, echo and close", "[UringStreamSocket]")
+{
+    using namespace UringTest;
+    using std::chrono::seconds;
+
+    const int32_t port = 47201;
+    UringStreamSocket socket;
+    socket.bind(port);
+
+    int fd = connectTo(port);
+    auto connected = socket.recvWait(seconds(5));
+    REQUIRE(connected != nullptr);
+    REQUIRE(connected->type() == MessageType::CONNECT);
+    int64_t sid = connected->sid();
+
+    SECTION("A frame is parsed and its echo reaches the client")
+    {
+        auto bytes = frame(Header(1, 100, 7, 0), "hello");
+        writeAll(fd, bytes.data(), bytes.size());
+
+        auto message = socket.recvWait(seconds(5));
+        REQUIRE(message != nullptr);
+        REQUIRE(message->type() == MessageType::NORMAL);
+        REQUIRE(message->sid() == sid);
+        REQUIRE(message->header().msg_id == 100);
+        REQUIRE(message->header().msg_seq == 7);
+        REQUIRE(text(*message) == "hello");
+
+        auto body = message->bodyView();
+        REQUIRE(socket.send(ClientMessage(sid,
+                                          message->header(),
+                                          body.data(),
+                                          body.size())) ==
+                SendStatus::Queued);
+        REQUIRE(readExactly(fd, body.size()) == "hello");
+    }
+
+    SECTION("Frames split across reads are reassembled")
+    {
+        std::vector<unsigned char> bytes;
+        for (int i = 0; i < 3; i++)
+        {
+            auto one = frame(Header(1, i, 0, 0), std::string(100, 'a' + i));
+            bytes.insert(bytes.end(), one.begin(), one.end());
+        }
+        // cut through the middle of the first header and the last body
+        writeAll(fd, bytes.data(), 5);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        writeAll(fd, bytes.data() + 5, bytes.size() - 55);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        writeAll(fd, bytes.data() + bytes.size() - 50, 50);
+
+        for (int i = 0; i < 3; i++)
+        {
+            auto message = socket.recvWait(seconds(5));
+            REQUIRE(message != nullptr);
+            REQUIRE(message->header().msg_id == i);
+            REQUIRE(text(*message) == std::string(100, 'a' + i));
+        }
+    }
+
+    SECTION("Broadcast reaches every listed session")
+    {
+        int other = connectTo(port);
+        auto second = socket.recvWait(seconds(5));
+        REQUIRE(second != nullptr);
+        REQUIRE(second->type() == MessageType::CONNECT);
+
+        std::vector<int64_t> sids = {sid, second->sid(), sid + 1000};
+        const unsigned char news[] = {'n', 'e', 'w', 's'};
+        SharedPayload payload{std::span<const unsigned char>(news)};
+        REQUIRE(socket.broadcast(sids, payload) == 2);
+        REQUIRE(readExactly(fd, 4) == "news");
+        REQUIRE(readExactly(other, 4) == "news");
+        ::close(other);
+    }
+
+    SECTION("A closed client is reported and forgotten")
+    {
+        ::close(fd);
+        fd = -1;
+
+        auto message = socket.recvWait(seconds(5));
+        REQUIRE(message != nullptr);
+        REQUIRE(message->type() == MessageType::DISCONNECT);
+        REQUIRE(message->sid() == sid);
+
+        unsigned char body = 1;
+        REQUIRE(socket.send(ClientMessage(sid, Header(), &body, 1)) ==
+                SendStatus::UnknownSession);
+    }
+
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+    socket.close();
+}
+
+#endif
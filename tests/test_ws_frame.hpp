@@ -0,0 +1,36 @@
+#pragma once
+
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+#include "ws_frame.hpp"
+
+using namespace Play;
+
+TEST_CASE("WSFrameHeader functionality", "[WSFrameHeader]")
+{
+    auto header = [](size_t payloadSize) {
+        WSFrameHeader frameHeader = WSFrameHeader::binary(payloadSize);
+        auto bytes = frameHeader.bytes();
+        return std::vector<unsigned char>(bytes.begin(), bytes.end());
+    };
+
+    SECTION("Short payloads fit the first length byte")
+    {
+        REQUIRE(header(0) == std::vector<unsigned char>{0x82, 0});
+        REQUIRE(header(125) == std::vector<unsigned char>{0x82, 125});
+    }
+
+    SECTION("Medium payloads use a 16-bit length")
+    {
+        REQUIRE(header(126) == std::vector<unsigned char>{0x82, 126, 0, 126});
+        REQUIRE(header(65535) ==
+                std::vector<unsigned char>{0x82, 126, 0xFF, 0xFF});
+    }
+
+    SECTION("Large payloads use a 64-bit length")
+    {
+        REQUIRE(header(65536) ==
+                std::vector<unsigned char>{0x82, 127, 0, 0, 0, 0, 0, 1, 0, 0});
+    }
+}